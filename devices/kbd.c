@@ -6,6 +6,7 @@
 #include "devices/input.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/thread.h"
 
 /* Keyboard data register port. */
 #define DATA_REG 0x60
@@ -115,6 +116,10 @@ keyboard_interrupt (struct intr_frame *args UNUSED) {
 		/* Caps Lock. */
 		if (!release)
 			caps_lock = !caps_lock;
+	} else if (code == 0x58) {
+		/* F12: dump per-thread scheduler statistics. */
+		if (!release)
+			thread_dump_stats ();
 	} else if (map_key (invariant_keymap, code, &c)
 			|| (!shift && map_key (unshifted_keymap, code, &c))
 			|| (shift && map_key (shifted_keymap, code, &c))) {
@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -17,6 +18,10 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency and the number of PIT counts per timer tick. */
+#define PIT_HZ 1193180
+#define PIT_COUNT_PER_TICK ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
@@ -24,10 +29,25 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* NOTE: [Improve] tickless 모드를 위한 데이터
+   tickless 모드에서는 TSC를 단조 증가 카운터로 사용한다.
+   tick N은 TSC 값 tsc_base + N * tsc_per_tick에서 시작한다. */
+bool timer_tickless;		   /* -tickless 옵션 */
+static uint64_t tsc_per_tick;  /* tick당 TSC 증가량, 보정 전에는 0 */
+static uint64_t tsc_base;	   /* tick 0에 해당하는 TSC 값 */
+static bool timer_oneshot;	   /* PIT가 one-shot 모드로 설정되어 있는지 여부 */
+static bool timer_idle;		   /* idle 쓰레드가 tick 없이 잠들어 있는지 여부 */
+static long long oneshot_cnt;  /* one-shot 모드로 전환한 횟수 */
+
 static intr_handler_func timer_interrupt;
+static void timer_tick(void);
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
+static void pit_program(int mode, uint16_t count);
+static bool tsc_active(void);
+static int64_t tsc_to_ticks(uint64_t tsc);
+static void tsc_calibrate(void);
 
 /**
  * @brief 8254 프로그래머블 인터벌 타이머(PIT)를 설정하여 초당 PIT_FREQ 번 인터럽트가 발생하도록 하고, 해당 인터럽트를 등록합니다.
@@ -40,11 +60,7 @@ void timer_init(void)
 {
 	/* 8254 input frequency divided by TIMER_FREQ, rounded to
 	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-
-	outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb(0x40, count & 0xff);
-	outb(0x40, count >> 8);
+	pit_program(2, PIT_COUNT_PER_TICK); /* mode 2: rate generator */
 
 	intr_register_ext(0x20, timer_interrupt, "8254 Timer"); /* 인터럽트 핸들러 등록 */
 }
@@ -73,6 +89,99 @@ void timer_calibrate(void)
 			loops_per_tick |= test_bit;
 
 	printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
+
+	if (timer_tickless)
+		tsc_calibrate();
+}
+
+/**
+ * @brief tickless 모드를 위해 TSC를 PIT tick에 맞춰 보정하는 함수
+ *
+ * 주기적 tick이 동작하는 동안 몇 tick 사이의 TSC 증가량을 재고,
+ * 현재 ticks에 맞도록 tsc_base를 정한다. 이후 timer_ticks()는 TSC로부터 계산된다.
+ */
+static void
+tsc_calibrate(void)
+{
+	enum intr_level old_level;
+	uint64_t start_tsc;
+	int64_t start;
+
+	printf("Calibrating TSC...  ");
+
+	/* Wait for a timer tick. */
+	start = ticks;
+	while (ticks == start)
+		barrier();
+
+	start = ticks;
+	start_tsc = rdtsc();
+	while (ticks < start + 8)
+		barrier();
+
+	old_level = intr_disable();
+	tsc_per_tick = (rdtsc() - start_tsc) / (ticks - start);
+	tsc_base = rdtsc() - ticks * tsc_per_tick;
+	intr_set_level(old_level);
+
+	printf("%'" PRIu64 " cycles/s.\n", tsc_per_tick * TIMER_FREQ);
+}
+
+/**
+ * @brief idle 쓰레드가 hlt하기 직전에 호출되어 주기적 tick을 멈추는 함수
+ *
+ * PIT를 one-shot 모드로 바꾸어 다음 wakeup 시점(thread_next_wakeup())에만
+ * 인터럽트가 발생하도록 한다. 8254의 카운터는 16비트이므로 한 번에
+ * 약 55ms보다 길게 잠들 수는 없다. 인터럽트가 꺼진 상태에서 호출되어야 한다.
+ */
+void timer_idle_enter(void)
+{
+	int64_t deadline, now;
+	uint64_t tsc, count = 0xffff;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (!tsc_active())
+		return;
+
+	tsc = rdtsc();
+	now = tsc_to_ticks(tsc);
+	deadline = thread_next_wakeup();
+	if (deadline - now <= 0xffff / PIT_COUNT_PER_TICK)
+	{
+		uint64_t deadline_tsc = tsc_base + deadline * tsc_per_tick;
+
+		count = deadline_tsc > tsc ? (deadline_tsc - tsc) * PIT_COUNT_PER_TICK / tsc_per_tick : 1;
+		if (count == 0)
+			count = 1;
+		else if (count > 0xffff)
+			count = 0xffff;
+	}
+
+	pit_program(0, count); /* mode 0: interrupt on terminal count */
+	timer_oneshot = true;
+	timer_idle = true;
+	oneshot_cnt++;
+}
+
+/**
+ * @brief idle 쓰레드가 깨어난 뒤 호출되어 주기적 tick 복귀를 준비하는 함수
+ *
+ * 다음 tick 경계에 one-shot 인터럽트를 걸어 두고, 그 인터럽트에서
+ * 주기적 모드로 되돌린다. 이렇게 하면 주기적 tick이 TSC의 tick 경계와 맞춰진다.
+ */
+void timer_idle_exit(void)
+{
+	uint64_t tsc, next_tsc, count;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (!timer_idle)
+		return;
+
+	tsc = rdtsc();
+	next_tsc = tsc_base + (tsc_to_ticks(tsc) + 1) * tsc_per_tick;
+	count = (next_tsc - tsc) * PIT_COUNT_PER_TICK / tsc_per_tick;
+	pit_program(0, count > 0 ? count : 1);
+	timer_idle = false;
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -81,6 +190,14 @@ timer_ticks(void)
 {
 	enum intr_level old_level = intr_disable();
 	int64_t t = ticks;
+
+	/* NOTE: [Improve] tickless 모드에서는 아직 인터럽트로 처리되지 않은 tick도 센다. */
+	if (tsc_active())
+	{
+		int64_t now = tsc_to_ticks(rdtsc());
+		if (now > t)
+			t = now;
+	}
 	intr_set_level(old_level);
 	barrier();
 	return t;
@@ -134,6 +251,8 @@ void timer_nsleep(int64_t ns)
 void timer_print_stats(void)
 {
 	printf("Timer: %" PRId64 " ticks\n", timer_ticks());
+	if (timer_tickless)
+		printf("Timer: %lld tickless idle periods\n", oneshot_cnt);
 }
 
 /* Timer interrupt handler. */
@@ -145,26 +264,52 @@ void timer_print_stats(void)
  */
 static void
 timer_interrupt(struct intr_frame *args UNUSED)
+{
+	int64_t target = ticks + 1;
+
+	/* NOTE: [Improve] tickless 모드에서는 TSC로 현재 tick을 구하고 밀린 tick을 모두 처리한다.
+	   인터럽트가 tick 경계보다 조금 일찍 도착할 수 있으므로 1/4 tick의 여유를 둔다. */
+	if (tsc_active())
+		target = tsc_to_ticks(rdtsc() + tsc_per_tick / 4);
+
+	while (ticks < target)
+		timer_tick();
+
+	/* one-shot 인터럽트가 왔다면 지금 주기적 모드로 되돌린다.
+	   timer_idle_enter()가 건 인터럽트로 깨어난 쓰레드에게 바로 전환되면
+	   idle 쓰레드가 timer_idle_exit()를 부르지 못하므로 여기서 idle 상태도 끝낸다.
+	   idle 쓰레드가 다시 잠들 때는 timer_idle_enter()가 새로 one-shot을 건다. */
+	if (timer_oneshot)
+	{
+		pit_program(2, PIT_COUNT_PER_TICK);
+		timer_oneshot = false;
+		timer_idle = false;
+	}
+}
+
+/* Advances the tick count by one and runs the per-tick work. */
+static void
+timer_tick(void)
 {
 	ticks++;
 	thread_tick();
 
 	/**
-	 * NOTE: [1.3]
-	 * - 4 tick마다 모든 쓰레드의 우선순위 재계산
-	 * - 1 sec마다 load_avg, recent_cpu 재계산
+	 * NOTE: [1.3/Improve]
+	 * - 4 tick마다 recent_cpu가 바뀐 쓰레드의 우선순위 재계산
+	 * - 1 sec마다 load_avg, 실행 가능한 쓰레드의 recent_cpu 재계산
 	 */
 	if (thread_mlfqs)
 	{
 		thread_incr_recent_cpu();
 
-		if (timer_ticks() % 4 == 0)
-			thread_all_calc_priority();
+		if (ticks % 4 == 0)
+			thread_mlfqs_recalc_priority();
 
-		if (timer_ticks() % TIMER_FREQ == 0)
+		if (ticks % TIMER_FREQ == 0)
 		{
 			calc_load_avg();
-			thread_all_calc_recent_cpu();
+			thread_mlfqs_decay_recent_cpu();
 		}
 	}
 
@@ -217,6 +362,22 @@ real_time_sleep(int64_t num, int32_t denom)
 	int64_t ticks = num * TIMER_FREQ / denom;
 
 	ASSERT(intr_get_level() == INTR_ON);
+
+	/* NOTE: [Improve] tickless 모드에서는 TSC로 tick보다 짧은 시간까지 정확히 기다린다.
+	   온전한 tick은 timer_sleep()으로 양보하고 남은 시간만 TSC를 보며 기다린다. */
+	if (tsc_active())
+	{
+		ASSERT(denom % 1000 == 0);
+		uint64_t cycles = num * (tsc_per_tick * TIMER_FREQ / 1000) / (denom / 1000);
+		uint64_t deadline = rdtsc() + cycles;
+
+		if (ticks > 0)
+			timer_sleep(ticks);
+		while (rdtsc() < deadline)
+			barrier();
+		return;
+	}
+
 	if (ticks > 0)
 	{
 		/* We're waiting for at least one full timer tick.  Use
@@ -233,3 +394,29 @@ real_time_sleep(int64_t num, int32_t denom)
 		busy_wait(loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 	}
 }
+
+/* Programs 8254 counter 0 in MODE (0: one-shot, 2: periodic)
+   with the given COUNT. */
+static void
+pit_program(int mode, uint16_t count)
+{
+	outb(0x43, 0x30 | (mode << 1)); /* CW: counter 0, LSB then MSB, MODE, binary. */
+	outb(0x40, count & 0xff);
+	outb(0x40, count >> 8);
+}
+
+/* Returns true if ticks are derived from the TSC, that is, if
+   tickless mode is enabled and the TSC has been calibrated. */
+static bool
+tsc_active(void)
+{
+	return timer_tickless && tsc_per_tick != 0;
+}
+
+/* Converts TSC value TSC into the number of timer ticks since
+   the OS booted. */
+static int64_t
+tsc_to_ticks(uint64_t tsc)
+{
+	return tsc > tsc_base ? (tsc - tsc_base) / tsc_per_tick : 0;
+}
@@ -5,7 +5,10 @@
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -33,6 +36,7 @@ struct inode {
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	struct rwlock dir_lock;             /* Directory entries, if a directory. */
 	struct inode_disk data;             /* Inode content. */
 };
 
@@ -53,10 +57,25 @@ byte_to_sector (const struct inode *inode, off_t pos) {
  * returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* NOTE: [Improve] open_inodes를 보호하는 rwlock.
+ * 이미 열린 inode를 찾는 경우가 대부분이므로 검색은 읽기 모드로,
+ * 삽입과 삭제만 쓰기 모드로 한다. */
+static struct rwlock open_inodes_lock;
+
+/* Cache of in-memory inodes.  A struct inode is a little over
+ * one sector, which malloc() would round up to 1 kB. */
+static struct kmem_cache *inode_cache;
+
+static struct inode *find_open_inode (disk_sector_t sector);
+
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	rw_init (&open_inodes_lock);
+	inode_cache = kmem_cache_create ("inode", sizeof (struct inode), 0, NULL);
+	if (inode_cache == NULL)
+		PANIC ("inode_init: out of memory");
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -101,39 +120,77 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
-	struct inode *inode;
+	struct inode *inode, *found;
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
-	}
+	rw_read_acquire (&open_inodes_lock);
+	inode = inode_reopen (find_open_inode (sector));
+	rw_read_release (&open_inodes_lock);
+	if (inode != NULL)
+		return inode;
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
+	inode = kmem_cache_alloc (inode_cache);
 	if (inode == NULL)
 		return NULL;
 
 	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
+	rw_init (&inode->dir_lock);
 	disk_read (filesys_disk, inode->sector, &inode->data);
+
+	/* Someone else may have opened it while we were reading. */
+	rw_write_acquire (&open_inodes_lock);
+	found = inode_reopen (find_open_inode (sector));
+	if (found == NULL)
+		list_push_front (&open_inodes, &inode->elem);
+	rw_write_release (&open_inodes_lock);
+
+	if (found != NULL) {
+		kmem_cache_free (inode_cache, inode);
+		return found;
+	}
 	return inode;
 }
 
+/* Returns the open inode for SECTOR, or a null pointer if it is
+ * not open.  open_inodes_lock must be held. */
+static struct inode *
+find_open_inode (disk_sector_t sector) {
+	struct list_elem *e;
+
+	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
+			e = list_next (e)) {
+		struct inode *inode = list_entry (e, struct inode, elem);
+		if (inode->sector == sector)
+			return inode;
+	}
+	return NULL;
+}
+
+/* Returns the rwlock that guards the entries of directory
+ * INODE.  Every struct dir open on the same directory shares
+ * INODE, so they also share the lock. */
+struct rwlock *
+inode_dir_lock (struct inode *inode) {
+	ASSERT (inode != NULL);
+	return &inode->dir_lock;
+}
+
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	/* Readers of open_inodes_lock and file_reopen() or dir_reopen()
+	 * callers may reopen concurrently, so open_cnt is only changed
+	 * with interrupts off. */
+	if (inode != NULL) {
+		enum intr_level old_level = intr_disable ();
 		inode->open_cnt++;
+		intr_set_level (old_level);
+	}
 	return inode;
 }
 
@@ -148,14 +205,26 @@ inode_get_inumber (const struct inode *inode) {
  * If INODE was also a removed inode, frees its blocks. */
 void
 inode_close (struct inode *inode) {
+	enum intr_level old_level;
+	bool last;
+
 	/* Ignore null pointer. */
 	if (inode == NULL)
 		return;
 
-	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
+	/* Release resources if this was the last opener.
+	 * Hold the write lock so that inode_open() cannot find INODE
+	 * between the last close and its removal from the list.
+	 * Decrement with interrupts off, as inode_reopen() increments,
+	 * since callers holding a reference reopen without the lock. */
+	rw_write_acquire (&open_inodes_lock);
+	old_level = intr_disable ();
+	last = --inode->open_cnt == 0;
+	intr_set_level (old_level);
+	if (last) {
 		/* Remove from inode list and release lock. */
 		list_remove (&inode->elem);
+		rw_write_release (&open_inodes_lock);
 
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
@@ -164,8 +233,9 @@ inode_close (struct inode *inode) {
 					bytes_to_sectors (inode->data.length)); 
 		}
 
-		free (inode); 
-	}
+		kmem_cache_free (inode_cache, inode);
+	} else
+		rw_write_release (&open_inodes_lock);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -36,6 +36,9 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Stride scheduler. */
+	SYS_SETTICKETS,             /* Set this process's tickets. */
 };
 
 #endif /* lib/syscall-nr.h */
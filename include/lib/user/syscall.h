@@ -38,6 +38,9 @@ void close(int fd);
 
 int dup2(int oldfd, int newfd);
 
+/* Stride scheduler. */
+int settickets(int tickets);
+
 /* Project 3 and optionally project 4. */
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap(void *addr);
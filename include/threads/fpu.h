@@ -0,0 +1,18 @@
+#ifndef THREADS_FPU_H
+#define THREADS_FPU_H
+
+#include <stdbool.h>
+
+struct thread;
+
+/* NOTE: [Improve] 지연(lazy) FPU/SSE 문맥 교환
+ * 문맥 교환 때는 CR0.TS만 켜 두고, 쓰레드가 실제로 FPU/SSE 명령을 쓰다가
+ * #NM이 나면 그때 이전 소유자의 상태를 저장하고 자신의 상태를 복원한다. */
+void fpu_init(void);
+void fpu_switch(struct thread *next);
+void fpu_release(struct thread *t);
+void fpu_reset(struct thread *t);
+bool fpu_copy(struct thread *dst, struct thread *src);
+void fpu_print_stats(void);
+
+#endif /* threads/fpu.h */
@@ -3,11 +3,18 @@
 
 #include <debug.h>
 #include <stddef.h>
+#include <stdint.h>
 
-void malloc_init (void);
+/* Empty arenas kept per size class before they are given back. */
+extern size_t malloc_empty_keep;
+
+void malloc_init (uint64_t mem_end);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
 void free (void *);
+size_t malloc_shrink (void);
+size_t malloc_pages (void);
+void malloc_print_stats (void);
 
 #endif /* threads/malloc.h */
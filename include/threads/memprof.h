@@ -0,0 +1,27 @@
+#ifndef THREADS_MEMPROF_H
+#define THREADS_MEMPROF_H
+
+/* NOTE: [Improve] Kernel memory profiler.
+   Only built with "make MEMPROF=1", which defines MEMPROF.  Every
+   malloc(), calloc(), realloc() and palloc_get_*() call is recorded
+   with its call site, size and calling thread until it is freed. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Allocator that an allocation came from. */
+enum memprof_kind {
+	MEMPROF_MALLOC,             /* malloc(), calloc(), realloc(). */
+	MEMPROF_PALLOC,             /* palloc_get_page(), palloc_get_multiple(). */
+	MEMPROF_KIND_CNT
+};
+
+void memprof_init (void);
+void memprof_alloc (enum memprof_kind, void *, size_t size, void *caller);
+void memprof_free (enum memprof_kind, void *);
+uint64_t memprof_mark (void);
+size_t memprof_leaks (uint64_t mark, const char *name);
+void memprof_print_stats (void);
+
+#endif /* threads/memprof.h */
@@ -1,6 +1,7 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
@@ -14,10 +15,24 @@ enum palloc_flags {
 /* Maximum number of pages to put in user pool. */
 extern size_t user_page_limit;
 
+/* Page magazine watermarks.
+   Controlled by kernel command-line option "-pmag=HIGH[,BATCH]". */
+extern size_t palloc_mag_high;
+extern size_t palloc_mag_batch;
+
+/* Called when the kernel pool runs out of pages.  Gives cached
+   pages back and returns how many.  Must not sleep. */
+typedef size_t palloc_shrinker_func (void);
+
 uint64_t palloc_init (void);
 void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
+void *palloc_get_aligned (enum palloc_flags, size_t page_cnt, size_t align);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void palloc_print_stats (void);
+bool palloc_set_magazine (size_t high, size_t batch);
+bool palloc_zero_idle (void);
+void palloc_register_shrinker (palloc_shrinker_func *);
 
 #endif /* threads/palloc.h */
@@ -41,5 +41,15 @@
 #define PTE_U 0x4                        /* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20                       /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40                       /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80                      /* 1=2 MB page, 0=page table (PDEs only). */
+
+/* NOTE: [Improve] Large pages.
+   A PDE with PTE_PS set maps a 2 MB page directly, with no page
+   table below it.  The walkers in mmu.c return such a PDE in
+   place of a PTE, so its P, W, U, A and D bits work the same. */
+#define LPGSIZE (1UL << PDXSHIFT)        /* Bytes in a large page. */
+#define LPGMASK (LPGSIZE - 1)            /* Offset bits in a large page. */
+#define LPG_PAGES (LPGSIZE / PGSIZE)     /* 4 kB pages in a large page. */
+#define PDE_ADDR(pde) ((uint64_t) (pde) & ~LPGMASK)
 
 #endif /* threads/pte.h */
@@ -0,0 +1,33 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* NOTE: [Improve] Object caches.
+   A cache hands out objects of one exact size, packed into
+   single-page slabs, instead of rounding them up to a power of 2
+   like malloc() does.  Each cache has a magazine of recently
+   freed objects in front of its slabs.
+
+   If CTOR is non-null it is run once on every object when its slab
+   is created, and objects are expected to be returned to the cache
+   in their constructed state.  Caches without a constructor give
+   out objects with unspecified contents. */
+struct kmem_cache;
+
+/* Object constructor. */
+typedef void kmem_ctor_func (void *obj);
+
+void slab_init (void);
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+		size_t align, kmem_ctor_func *ctor);
+void kmem_cache_destroy (struct kmem_cache *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void *kmem_cache_zalloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+size_t kmem_cache_shrink (struct kmem_cache *);
+size_t kmem_cache_objs_per_slab (const struct kmem_cache *);
+size_t kmem_cache_slabs (const struct kmem_cache *);
+void slab_print_stats (void);
+
+#endif /* threads/slab.h */
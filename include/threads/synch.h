@@ -1,6 +1,7 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
 
@@ -8,7 +9,7 @@
 struct semaphore
 {
 	unsigned value;		 /* Current value. */
-	struct list waiters; /* List of waiting threads. */
+	struct heap waiters; /* Waiting threads, highest priority first. */
 };
 
 void sema_init(struct semaphore *, unsigned value); /* 새로운 세마포어 구조체인 sema를 주어진 초기값으로 초기화 */
@@ -22,6 +23,11 @@ struct lock
 {
 	struct thread *holder;		/* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+
+	/* NOTE: [Improve] lock 단위 donation 관리 */
+	int max_priority;	   /* 기다리는 쓰레드 중 가장 높은 우선순위 */
+	int donated_tickets;   /* 기다리는 쓰레드들이 넘겨준 티켓 수의 합 */
+	struct list_elem elem; /* holder의 held_locks element */
 };
 
 void lock_init(struct lock *);		  /* 새로운 lock 구조체 초기화 */
@@ -30,10 +36,57 @@ bool lock_try_acquire(struct lock *); /* 기다리지 않고 현재 쓰레드가
 void lock_release(struct lock *);	  /* lock을 놓아준다. */
 bool lock_held_by_current_thread(const struct lock *);
 
+/* NOTE: [Improve] 짧은 임계 구역을 위한 가벼운 lock.
+   경쟁이 없으면 리스트나 donation을 전혀 건드리지 않고 holder만 설정한다.
+   경쟁 시에는 holder가 다른 CPU에서 실행 중일 때만 잠시 돌며 기다리고, 아니면 바로 잠든다.
+   priority donation을 하지 않으므로 오래 잡는 lock에는 쓰지 않는다. */
+struct mutex_fast
+{
+	struct thread *holder; /* Thread holding the mutex. */
+	struct heap waiters;   /* Blocked threads, highest priority first. */
+};
+
+void mutex_fast_init(struct mutex_fast *);
+void mutex_fast_acquire(struct mutex_fast *);
+bool mutex_fast_try_acquire(struct mutex_fast *);
+void mutex_fast_release(struct mutex_fast *);
+bool mutex_fast_held_by_current_thread(const struct mutex_fast *);
+void synch_print_stats(void);
+
+/* NOTE: [Improve] Reader-writer lock.
+   writer는 내부 lock을 잡고 있으므로 기존 priority donation이 그대로 적용된다.
+   reader는 내부 lock을 잠깐 잡아 등록만 하고 놓으므로 여러 reader가 동시에 들어올 수 있다.
+   writer는 남은 reader들에게 자신의 우선순위를 donation하고 reader가 모두 나갈 때까지 기다린다. */
+struct rwlock
+{
+	struct lock lock;		/* Held by the writer. */
+	struct list readers;	/* List of rw_hold elements of readers. */
+	struct semaphore drain; /* Signaled when the last reader leaves. */
+	bool writer_waiting;	/* Writer waits on drain. */
+};
+
+/* One read hold of a thread.  Each thread can hold up to
+   RW_HOLD_MAX read locks at the same time; past that,
+   rw_read_acquire() takes the lock for writing instead. */
+#define RW_HOLD_MAX 4
+struct rw_hold
+{
+	struct rwlock *rwlock; /* Read-held rwlock, null if unused. */
+	struct thread *thread; /* Reader. */
+	struct list_elem elem; /* rwlock's readers list element. */
+};
+
+void rw_init(struct rwlock *);
+void rw_read_acquire(struct rwlock *);
+void rw_read_release(struct rwlock *);
+void rw_write_acquire(struct rwlock *);
+void rw_write_release(struct rwlock *);
+bool rw_write_held_by_current_thread(const struct rwlock *);
+
 /* Condition variable. */
 struct condition
 {
-	struct list waiters; /* List of waiting threads. */
+	struct heap waiters; /* Waiting threads, highest priority first. */
 };
 
 void cond_init(struct condition *);
@@ -41,9 +94,7 @@ void cond_wait(struct condition *, struct lock *);
 void cond_signal(struct condition *, struct lock *);
 void cond_broadcast(struct condition *, struct lock *);
 
-bool cmp_condition(struct list_elem *a, struct list_elem *b, void *aux);
-bool cmp_donation(struct list_elem *a, struct list_elem *b, void *aux);
-void remove_donations(struct lock *lock);
+bool cmp_lock_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
 void donate_priority(void);
 void update_donate_priority(void);
 /* Optimization barrier.
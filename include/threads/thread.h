@@ -31,6 +31,16 @@ typedef int tid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63	   /* Highest priority. */
 
+/* NOTE: [Improve] Stride scheduler tickets. */
+#define TICKETS_MIN 1		/* Fewest tickets. */
+#define TICKETS_DEFAULT 100 /* Default tickets. */
+#define TICKETS_MAX 10000	/* Most tickets. */
+#define STRIDE1 (1 << 20)	/* Pass advanced per tick with a single ticket. */
+
+/* NOTE: [Improve] EDF admission limit: total runtime/period of
+   all deadline threads, in thousandths. */
+#define EDF_UTIL_MAX 950
+
 #define FDT_PAGES 3 // fdt 할당 시 필요한 페이지 개수
 #define FDT_MAX 128
 
@@ -86,11 +96,32 @@ typedef int tid_t;
  * set to THREAD_MAGIC.  Stack overflow will normally change this
  * value, triggering the assertion. */
 /* The `elem' member has a dual purpose.  It can be an element in
- * the run queue (thread.c), or it can be an element in a
- * semaphore wait list (synch.c).  It can be used these two ways
+ * a per-priority run queue (thread.c), or it can be an element in
+ * the sleep timing wheel (thread.c).  It can be used these two ways
  * only because they are mutually exclusive: only a thread in the
- * ready state is on the run queue, whereas only a thread in the
- * blocked state is on a semaphore wait list. */
+ * ready state is on the run queue, whereas only a sleeping thread
+ * is on the timing wheel.  Threads waiting on a synchronization
+ * object use `wait_elem' instead (synch.c). */
+
+/* NOTE: [Improve] 쓰레드별 스케줄러 통계
+ * ready 큐 대기 시간은 tick 단위의 log2 히스토그램으로 기록한다.
+ * 버킷 0은 0 tick, 버킷 i는 [2^(i-1), 2^i) tick, 마지막 버킷은 그 이상이다. */
+#define THREAD_WAIT_BUCKETS 8
+struct thread_stats
+{
+	int64_t run_ticks;								/* 실행한 tick 수 */
+	int64_t boosted_ticks;							/* donation 받은 우선순위로 실행한 tick 수 */
+	long long voluntary_switches;					/* block, sleep, exit 등으로 스스로 내려간 횟수 */
+	long long involuntary_switches;					/* 선점당한 횟수 */
+	long long slice_expiries;						/* time slice를 다 써서 선점당한 횟수 */
+	long long ready_wait[THREAD_WAIT_BUCKETS];		/* ready 큐 대기 시간 히스토그램 */
+	int64_t ready_since;							/* ready 큐에 들어간 tick */
+	int64_t sleep_overshoot;						/* wakeup_tick보다 늦게 실행된 tick의 합 */
+	long long sleep_cnt;							/* sleep 횟수 */
+	bool sleeping;									/* thread_sleep()으로 잠든 상태인지 여부 */
+	bool preempted;									/* 선점으로 양보하는 중인지 여부 */
+};
+
 struct thread
 {
 	/* Owned by thread.c. */
@@ -99,19 +130,55 @@ struct thread
 	char name[16];			   /* Name (for debugging purposes). */
 	int priority;			   /* Priority. */
 	int64_t wakeup_tick;	   /* wakeup 할 시간 저장 */
-	struct list donations;
-	struct list_elem d_elem;
-	struct list_elem donation_elem;
-	int origin_priority;
-	struct lock *wait_on_lock;
+	struct list held_locks;	   /* 가지고 있는 lock들, max_priority 내림차순 */
+	int origin_priority;	   /* donation 받기 전 우선순위 */
+	struct lock *wait_on_lock; /* 기다리고 있는 lock */
+	struct rwlock *wait_on_rwlock; /* reader가 나가기를 기다리는 rwlock */
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem; /* List element. */
 
+	/* NOTE: [Improve] semaphore, lock, condition의 waiters heap 정보 */
+	struct heap_elem wait_elem; /* waiters heap element */
+	struct heap *wait_heap;		/* 들어가 있는 waiters heap, 없으면 NULL */
+	uint64_t wait_seq;			/* 같은 우선순위 안에서의 도착 순서 */
+
 	/* NOTE: [1.3] MLFQ를 위한 데이터 추가 - nice, recent_cpu */
 	int nice;			/* 쓰레드의 친절함을 나타내는 지표 */
 	int32_t recent_cpu; /* 쓰레드의 최근 CPU 사용량을 나타내는 지표 */
 
+	/* NOTE: [Improve] MLFQS 점진적 재계산을 위한 데이터 */
+	int64_t recent_cpu_sec;		/* recent_cpu에 마지막으로 감쇄를 적용한 시점(초) */
+	bool mlfqs_dirty;			/* 우선순위 재계산이 필요한지 여부 */
+	struct list_elem mlfqs_elem; /* mlfqs_dirty_list element */
+
+	/* NOTE: [Improve] reader-writer lock의 read hold */
+	struct rw_hold rw_holds[RW_HOLD_MAX];
+
+	/* NOTE: [Improve] stride 스케줄러를 위한 데이터 */
+	int tickets;				   /* 자신의 티켓 수 */
+	int donated_tickets;		   /* lock을 기다리는 쓰레드에게서 받은 티켓 수 */
+	uint64_t pass;				   /* 다음에 실행될 가상 시간 */
+	struct heap_elem stride_elem; /* stride ready heap element */
+
+	/* NOTE: [Improve] EDF 스케줄링 클래스를 위한 데이터 (단위: tick) */
+	bool edf;					/* EDF 클래스에 속하는지 여부 */
+	bool edf_throttled;			/* 이번 주기의 budget을 다 써서 멈춘 상태인지 여부 */
+	int64_t edf_runtime;		/* 주기마다 쓸 수 있는 실행 시간 */
+	int64_t edf_period;			/* 주기 */
+	int64_t edf_rel_deadline;	/* 주기 시작부터의 상대 deadline */
+	int64_t edf_period_start;	/* 현재 주기의 시작 tick */
+	int64_t edf_deadline;		/* 현재 주기의 절대 deadline */
+	int64_t edf_budget;			/* 현재 주기에 남은 실행 시간 */
+	long long edf_jobs;			/* 끝낸 job 수 */
+	long long edf_misses;		/* deadline을 넘겨 끝낸 job 수 */
+	long long edf_overruns;		/* budget을 다 써서 멈춘 횟수 */
+	struct heap_elem edf_elem; /* EDF ready heap element */
+
+	/* NOTE: [Improve] 스케줄러 통계 */
+	struct thread_stats stats;
+	int slice_shift;		   /* NOTE: [Improve] 적응형 time slice 배율(log2), thread_slice() 참고 */
+
 	/* NOTE: [Improve] all_list element */
 	struct list_elem all_elem;
 
@@ -151,6 +218,9 @@ struct thread
 
 	/* Owned by thread.c. */
 	struct intr_frame tf; /* Information for switching */
+	uint64_t switch_rsp;  /* NOTE: [Improve] switch_threads()가 저장한 rsp, 실행 전이면 0 */
+	void *fpu_state;	  /* NOTE: [Improve] FXSAVE 영역, FPU를 처음 쓸 때 할당 (fpu.c) */
+	bool fpu_used;		  /* fpu_state에 저장할 FPU 상태가 있는지 여부 */
 	unsigned magic;		  /* Detects stack overflow. */
 };
 
@@ -159,11 +229,30 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use stride scheduler.
+   Controlled by kernel command-line option "-stride". */
+extern bool thread_stride;
+
+/* Maximum number of dead threads' pages kept for reuse.
+   Controlled by kernel command-line option "-tcache=N". */
+extern size_t thread_cache_max;
+
+/* NOTE: [Improve] 적응형 time slice
+   우선순위별 기본 time slice(tick)에 쓰레드별 배율 2^slice_shift를 곱해 쓴다.
+   slice를 다 쓰고 선점된 쓰레드는 배율을 키우고, slice의 절반도 쓰기 전에
+   block된 쓰레드는 배율을 줄인다.  기본값은 "-slice" 옵션으로 바꿀 수 있다. */
+#define TIME_SLICE 4				/* 기본 time slice (tick) */
+#define SLICE_SHIFT_MIN (-2)		/* 가장 짧은 배율: 1/4 */
+#define SLICE_SHIFT_MAX 2			/* 가장 긴 배율: 4배 */
+
 void thread_init(void);
 void thread_start(void);
 
 void thread_tick(void);
 void thread_print_stats(void);
+void thread_dump_stats(void);
+bool thread_set_slice(int priority, unsigned ticks);
+unsigned thread_slice(const struct thread *t);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
@@ -180,9 +269,18 @@ void thread_compare_yield(void);
 void thread_yield(void);
 void thread_sleep(int64_t wakeup_tick);
 void thread_wakeup(int64_t curr_tick);
+int64_t thread_next_wakeup(void);
 
 int thread_get_priority(void);
 void thread_set_priority(int);
+void thread_update_priority(struct thread *t, int priority);
+
+bool thread_set_deadline(int64_t runtime, int64_t period, int64_t deadline);
+void thread_clear_deadline(void);
+long long thread_get_deadline_misses(void);
+
+int thread_get_tickets(void);
+int thread_set_tickets(int);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
@@ -190,15 +288,14 @@ int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
 
 void thread_calc_priority(struct thread *t);
-void thread_calc_recent_cpu(struct thread *t);
 void thread_incr_recent_cpu(void);
 void calc_load_avg(void);
-void thread_all_calc_priority(void);
-void thread_all_calc_recent_cpu(void);
+void thread_mlfqs_recalc_priority(void);
+void thread_mlfqs_decay_recent_cpu(void);
 
 // static cmp_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux);
 
-bool compare_priority(struct list_elem *a, struct list_elem *b, void *aux UNUSED);
+bool compare_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
 void do_iret(struct intr_frame *tf);
 bool cmp_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
 
@@ -0,0 +1,48 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/synch.h"
+
+/* NOTE: [Improve] 인터럽트나 시스템 콜 경로에서 미뤄 둔 일을 처리하는 workqueue.
+   각 workqueue는 고정된 수의 커널 worker 쓰레드를 가지고,
+   worker들은 workqueue의 우선순위로 실행된다. */
+
+/* Function run by a worker for a work item. */
+typedef void work_func(void *aux);
+
+/* A work item.  Initialize with work_init() before submitting. */
+struct work
+{
+	struct list_elem elem; /* Element in workqueue's pending list. */
+	work_func *func;	   /* Function to run. */
+	void *aux;			   /* Argument to FUNC. */
+	bool pending;		   /* Submitted but not yet started. */
+};
+
+/* A queue of work items and the workers that run them. */
+struct workqueue
+{
+	const char *name;		 /* Name of the worker threads. */
+	bool started;			 /* True once the workers are created. */
+	struct list pending;	 /* Submitted work items. */
+	struct list idle;		 /* Idle worker threads. */
+	int running;			 /* # of work items being run. */
+	struct lock lock;		 /* Protects completion waiting. */
+	struct condition done;	 /* Signaled when a batch completes. */
+	long long submitted_cnt; /* # of work items submitted. */
+	long long batch_cnt;	 /* # of batches run by workers. */
+};
+
+/* Shared queue for short deferred work. */
+extern struct workqueue system_wq;
+
+void workqueue_init(struct workqueue *, const char *name, int priority, int worker_cnt);
+void workqueue_flush(struct workqueue *);
+void workqueue_print_stats(void);
+
+void work_init(struct work *, work_func *, void *aux);
+bool work_submit(struct workqueue *, struct work *);
+
+#endif /* threads/workqueue.h */
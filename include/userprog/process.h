@@ -1,8 +1,13 @@
 #ifndef USERPROG_PROCESS_H
 #define USERPROG_PROCESS_H
 
+#include <stdbool.h>
 #include "threads/thread.h"
 
+/* NOTE: [Improve] -ulpage: Map zero-filled stretches of user
+   segments with 2 MB pages? */
+extern bool user_large_pages;
+
 tid_t process_create_initd(const char *file_name);
 tid_t process_fork(const char *name, struct intr_frame *if_);
 int process_exec(void *f_name);
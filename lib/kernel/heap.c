@@ -0,0 +1,165 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* A pairing heap is a heap-ordered multiway tree.  Each node
+   keeps a pointer to its leftmost child and the children of a
+   node form a doubly linked sibling list.  The `prev' link of
+   the leftmost child points to the parent instead, and the root
+   has no `prev' or `next' link.
+
+   Insertion melds a single-node tree with the root.  Deleting
+   the root melds its children in two passes: first pairwise from
+   left to right, then the resulting trees one by one from right
+   to left.  This gives amortized O(log n) deletion. */
+
+static struct heap_elem *meld (struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static struct heap_elem *combine_siblings (struct heap *,
+		struct heap_elem *first);
+
+/* Initializes HEAP as an empty heap ordered by LESS given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *heap, heap_less_func *less, void *aux) {
+	ASSERT (heap != NULL);
+	ASSERT (less != NULL);
+
+	heap->root = NULL;
+	heap->size = 0;
+	heap->less = less;
+	heap->aux = aux;
+}
+
+/* Inserts ELEM into HEAP. */
+void
+heap_insert (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	elem->child = elem->next = elem->prev = NULL;
+	heap->root = heap->root != NULL ? meld (heap, heap->root, elem) : elem;
+	heap->size++;
+}
+
+/* Returns the least element in HEAP.
+   Undefined behavior if HEAP is empty. */
+struct heap_elem *
+heap_min (struct heap *heap) {
+	ASSERT (!heap_empty (heap));
+	return heap->root;
+}
+
+/* Removes the least element from HEAP and returns it.
+   Undefined behavior if HEAP is empty. */
+struct heap_elem *
+heap_pop_min (struct heap *heap) {
+	struct heap_elem *root = heap_min (heap);
+
+	heap->root = combine_siblings (heap, root->child);
+	heap->size--;
+	return root;
+}
+
+/* Removes ELEM, which must be in HEAP, from HEAP. */
+void
+heap_remove (struct heap *heap, struct heap_elem *elem) {
+	struct heap_elem *sub;
+
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	if (elem == heap->root) {
+		heap_pop_min (heap);
+		return;
+	}
+
+	/* Unlink ELEM from its sibling list. */
+	ASSERT (elem->prev != NULL);
+	if (elem->prev->child == elem)
+		elem->prev->child = elem->next;
+	else
+		elem->prev->next = elem->next;
+	if (elem->next != NULL)
+		elem->next->prev = elem->prev;
+
+	/* Meld ELEM's children back into the heap. */
+	sub = combine_siblings (heap, elem->child);
+	if (sub != NULL)
+		heap->root = meld (heap, heap->root, sub);
+	heap->size--;
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+heap_size (struct heap *heap) {
+	return heap->size;
+}
+
+/* Returns true if HEAP is empty, false otherwise. */
+bool
+heap_empty (struct heap *heap) {
+	return heap->root == NULL;
+}
+
+/* Melds the trees rooted at A and B, neither of which may have
+   siblings, and returns the root of the result. */
+static struct heap_elem *
+meld (struct heap *heap, struct heap_elem *a, struct heap_elem *b) {
+	/* Ties go to A, so equal elements keep their insertion order
+	   relative to the existing root. */
+	if (heap->less (b, a, heap->aux)) {
+		struct heap_elem *t = a;
+		a = b;
+		b = t;
+	}
+
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	a->prev = a->next = NULL;
+	return a;
+}
+
+/* Melds the sibling list starting at FIRST into a single tree
+   and returns its root, or a null pointer if FIRST is null. */
+static struct heap_elem *
+combine_siblings (struct heap *heap, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL, *result;
+
+	if (first == NULL)
+		return NULL;
+
+	/* First pass: meld pairs from left to right, collecting the
+	   results in reverse order through their `next' links. */
+	while (first != NULL) {
+		struct heap_elem *a = first, *b = a->next, *m;
+
+		if (b == NULL) {
+			a->prev = NULL;
+			a->next = pairs;
+			pairs = a;
+			break;
+		}
+		first = b->next;
+		a->next = b->next = NULL;
+		m = meld (heap, a, b);
+		m->next = pairs;
+		pairs = m;
+	}
+
+	/* Second pass: meld from right to left. */
+	result = pairs;
+	pairs = pairs->next;
+	result->next = NULL;
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->next;
+
+		pairs->next = NULL;
+		result = meld (heap, result, pairs);
+		pairs = next;
+	}
+	result->prev = NULL;
+	return result;
+}
@@ -194,3 +194,8 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+settickets (int tickets) {
+	return syscall1 (SYS_SETTICKETS, tickets);
+}
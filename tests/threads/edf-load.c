@@ -0,0 +1,117 @@
+/* Runs two deadline threads, each needing about 1 tick of CPU
+   time in every 10-tick period, next to three CPU-bound threads
+   of the same priority as the main thread.  The deadline
+   threads should finish every job before its deadline.  Also
+   checks that admission control rejects a deadline thread that
+   would overcommit the CPU. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define EDF_THREAD_CNT 2
+#define HOG_THREAD_CNT 3
+#define JOB_CNT 10
+#define PERIOD 10
+
+struct edf_result
+  {
+    long long jobs;
+    long long misses;
+    bool admitted;
+  };
+
+static thread_func edf_thread;
+static thread_func hog_thread;
+static struct edf_result results[EDF_THREAD_CNT];
+static struct semaphore admitted;
+static struct semaphore done_sema;
+static volatile bool hogs_stop;
+
+void
+test_edf_load (void) 
+{
+  int i;
+
+  sema_init (&admitted, 0);
+  sema_init (&done_sema, 0);
+  hogs_stop = false;
+
+  for (i = 0; i < HOG_THREAD_CNT; i++)
+    thread_create ("hog", PRI_DEFAULT, hog_thread, NULL);
+
+  for (i = 0; i < EDF_THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "edf %d", i);
+      thread_create (name, PRI_DEFAULT, edf_thread, &results[i]);
+    }
+
+  /* Both deadline threads use 20% of the CPU, so another 70%
+     must be rejected. */
+  for (i = 0; i < EDF_THREAD_CNT; i++)
+    sema_down (&admitted);
+  if (thread_set_deadline (7, PERIOD, PERIOD))
+    fail ("admitted a 70%% thread next to 40%% of deadline threads");
+  msg ("admission of a 70%% thread rejected.");
+
+  for (i = 0; i < EDF_THREAD_CNT; i++)
+    sema_down (&done_sema);
+  hogs_stop = true;
+  for (i = 0; i < HOG_THREAD_CNT; i++)
+    sema_down (&done_sema);
+
+  for (i = 0; i < EDF_THREAD_CNT; i++)
+    {
+      if (!results[i].admitted)
+        fail ("edf %d was not admitted", i);
+      msg ("edf %d: %lld jobs, %lld deadline misses.",
+           i, results[i].jobs, results[i].misses);
+    }
+}
+
+static void
+edf_thread (void *result_) 
+{
+  struct edf_result *result = result_;
+  int64_t next_period;
+  int i;
+
+  result->admitted = thread_set_deadline (2, PERIOD, PERIOD - 2);
+  sema_up (&admitted);
+  if (!result->admitted)
+    {
+      sema_up (&done_sema);
+      return;
+    }
+
+  next_period = timer_ticks ();
+  for (i = 0; i < JOB_CNT; i++) 
+    {
+      /* Busy-wait until the current time changes: at most one
+         tick of work. */
+      int64_t start = timer_ticks ();
+      while (timer_ticks () == start)
+        barrier ();
+
+      next_period += PERIOD;
+      timer_sleep (next_period - timer_ticks ());
+    }
+
+  /* Read our statistics before blocking for anything else. */
+  result->jobs = thread_current ()->edf_jobs;
+  result->misses = thread_get_deadline_misses ();
+  thread_clear_deadline ();
+  sema_up (&done_sema);
+}
+
+static void
+hog_thread (void *aux UNUSED) 
+{
+  while (!hogs_stop)
+    barrier ();
+  sema_up (&done_sema);
+}
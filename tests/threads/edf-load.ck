@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-load) begin
+(edf-load) admission of a 70% thread rejected.
+(edf-load) edf 0: 10 jobs, 0 deadline misses.
+(edf-load) edf 1: 10 jobs, 0 deadline misses.
+(edf-load) end
+EOF
+pass;
@@ -0,0 +1,75 @@
+/* Checks that SSE register state survives context switches.
+   Several threads each load a distinct value into %xmm0, yield
+   repeatedly so that the others overwrite the register, and then
+   verify that they get their own value back.  A thread that
+   never touches the FPU is mixed in to make sure switching to it
+   does not disturb anyone. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define FPU_THREAD_CNT 3
+#define YIELD_CNT 10
+
+static thread_func fpu_thread;
+static thread_func plain_thread;
+static struct semaphore done;
+static bool preserved[FPU_THREAD_CNT];
+
+void
+test_fpu_lazy (void) 
+{
+  int i;
+
+  sema_init (&done, 0);
+  for (i = 0; i < FPU_THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "fpu %d", i);
+      thread_create (name, PRI_DEFAULT, fpu_thread, (void *) (intptr_t) i);
+    }
+  thread_create ("plain", PRI_DEFAULT, plain_thread, NULL);
+
+  for (i = 0; i < FPU_THREAD_CNT + 1; i++)
+    sema_down (&done);
+
+  for (i = 0; i < FPU_THREAD_CNT; i++)
+    {
+      if (!preserved[i])
+        fail ("thread %d lost its %%xmm0 value", i);
+      msg ("thread %d: %%xmm0 preserved across %d yields.", i, YIELD_CNT);
+    }
+}
+
+static void
+fpu_thread (void *id_) 
+{
+  int id = (intptr_t) id_;
+  uint64_t expected = 0x0123456789abcdefULL * (id + 1);
+  uint64_t value;
+  int i;
+
+  preserved[id] = true;
+  for (i = 0; i < YIELD_CNT; i++) 
+    {
+      asm volatile ("movq %0, %%xmm0" : : "r" (expected + i));
+      thread_yield ();
+      asm volatile ("movq %%xmm0, %0" : "=r" (value));
+      if (value != expected + i)
+        preserved[id] = false;
+    }
+  sema_up (&done);
+}
+
+static void
+plain_thread (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < YIELD_CNT; i++)
+    thread_yield ();
+  sema_up (&done);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fpu-lazy) begin
+(fpu-lazy) thread 0: %xmm0 preserved across 10 yields.
+(fpu-lazy) thread 1: %xmm0 preserved across 10 yields.
+(fpu-lazy) thread 2: %xmm0 preserved across 10 yields.
+(fpu-lazy) end
+EOF
+pass;
@@ -0,0 +1,96 @@
+/* Measures malloc() throughput and memory use on a mix of request
+   sizes modeled on the kernel's own allocations: small records and
+   list nodes, argument strings, sector-sized bounce buffers, and a
+   few buffers of one to a few pages.  Keeps a working set of
+   SLOT_CNT blocks, randomly freeing and refilling them, and checks
+   that no block is overwritten.  The timing and the page count are
+   printed without the test-name prefix because they vary; only the
+   operation count is checked. */
+
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "devices/timer.h"
+
+#define SLOT_CNT 256
+#define OP_CNT 40000
+
+/* Request sizes and their relative frequencies. */
+static const struct
+  {
+    size_t size;
+    int weight;
+  }
+mix[] =
+  {
+    {24, 30}, {48, 20}, {128, 15}, {512, 15},
+    {1024, 5}, {2100, 5}, {4200, 5}, {12000, 5},
+  };
+
+static size_t
+pick_size (void) 
+{
+  int total = 0, r;
+  size_t i;
+
+  for (i = 0; i < sizeof mix / sizeof *mix; i++)
+    total += mix[i].weight;
+  r = random_ulong () % total;
+  for (i = 0; r >= mix[i].weight; i++)
+    r -= mix[i].weight;
+  return mix[i].size;
+}
+
+void
+test_malloc_bench (void) 
+{
+  static unsigned char *blocks[SLOT_CNT];
+  static size_t sizes[SLOT_CNT];
+  size_t live = 0, peak_live = 0, peak_pages = 0, base_pages;
+  int64_t start, elapsed;
+  int i;
+
+  random_init (0);
+  base_pages = malloc_pages ();
+  start = timer_ticks ();
+  for (i = 0; i < OP_CNT; i++)
+    {
+      int slot = random_ulong () % SLOT_CNT;
+
+      if (blocks[slot] != NULL)
+        {
+          if (blocks[slot][0] != (unsigned char) slot
+              || blocks[slot][sizes[slot] - 1] != (unsigned char) slot)
+            fail ("block in slot %d overwritten", slot);
+          free (blocks[slot]);
+          blocks[slot] = NULL;
+          live -= sizes[slot];
+          continue;
+        }
+
+      sizes[slot] = pick_size ();
+      blocks[slot] = malloc (sizes[slot]);
+      if (blocks[slot] == NULL)
+        fail ("malloc of %zu bytes failed", sizes[slot]);
+      blocks[slot][0] = blocks[slot][sizes[slot] - 1] = slot;
+      live += sizes[slot];
+      if (live > peak_live)
+        peak_live = live;
+      if (malloc_pages () - base_pages > peak_pages)
+        peak_pages = malloc_pages () - base_pages;
+    }
+  elapsed = timer_elapsed (start);
+
+  for (i = 0; i < SLOT_CNT; i++)
+    free (blocks[i]);
+  msg ("%d operations completed.", OP_CNT);
+
+  printf ("malloc-bench: %d ops in %"PRId64" ticks; "
+          "peak %zu live bytes in %zu pages (%zu%% used)\n",
+          OP_CNT, elapsed, peak_live, peak_pages,
+          peak_pages > 0 ? peak_live * 100 / (peak_pages * 4096) : 0);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^malloc-bench: \d+ ops in \d+ ticks/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(malloc-bench) begin
+(malloc-bench) 40000 operations completed.
+(malloc-bench) end
+EOF
+pass;
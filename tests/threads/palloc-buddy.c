@@ -0,0 +1,133 @@
+/* Exercises the buddy page allocator.  Allocates blocks of
+   assorted sizes, including sizes that are not powers of two,
+   checks that they do not overlap, and frees them in an order
+   that leaves holes.  Then takes every page of the kernel pool,
+   largest blocks first, to learn the largest block it can hand
+   out, takes the pool again one page at a time, frees every
+   other page before the rest, and checks that the holes were
+   merged back into a block of the largest size. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+#define BLOCK_CNT 24
+#define MAX_ORDER 20
+
+static const size_t sizes[] = {1, 2, 3, 4, 5, 8, 1, 7};
+
+/* Header at the start of each block taken by exhaust(). */
+struct chunk
+  {
+    struct chunk *next;
+    size_t page_cnt;
+  };
+
+/* Allocates blocks of PAGE_CNT pages until the kernel pool runs
+   out, pushes them onto *LIST, and returns how many it got. */
+static size_t
+exhaust (size_t page_cnt, struct chunk **list)
+{
+  struct chunk *c;
+  size_t cnt = 0;
+
+  while ((c = palloc_get_multiple (0, page_cnt)) != NULL)
+    {
+      c->next = *list;
+      c->page_cnt = page_cnt;
+      *list = c;
+      cnt++;
+    }
+  return cnt;
+}
+
+/* Frees every block on LIST. */
+static void
+free_chunks (struct chunk *list)
+{
+  while (list != NULL)
+    {
+      struct chunk *next = list->next;
+      palloc_free_multiple (list, list->page_cnt);
+      list = next;
+    }
+}
+
+void
+test_palloc_buddy (void) 
+{
+  uint8_t *blocks[BLOCK_CNT];
+  size_t cnts[BLOCK_CNT];
+  struct chunk *list = NULL, *odd = NULL;
+  size_t big_pages;
+  uint8_t *big;
+  int i, j, order, max_order = -1;
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      cnts[i] = sizes[i % (sizeof sizes / sizeof *sizes)];
+      blocks[i] = palloc_get_multiple (0, cnts[i]);
+      if (blocks[i] == NULL)
+        fail ("allocation %d of %zu pages failed", i, cnts[i]);
+      memset (blocks[i], i, cnts[i] * PGSIZE);
+    }
+  msg ("allocated %d blocks.", BLOCK_CNT);
+
+  /* Every block must still hold its own fill pattern. */
+  for (i = 0; i < BLOCK_CNT; i++)
+    for (j = 0; j < (int) (cnts[i] * PGSIZE); j += PGSIZE / 4)
+      if (blocks[i][j] != i)
+        fail ("block %d overwritten at offset %d", i, j);
+  msg ("blocks do not overlap.");
+
+  /* Free the even blocks first, then the odd ones, so that merging
+     has to happen out of order. */
+  for (i = 0; i < BLOCK_CNT; i += 2)
+    palloc_free_multiple (blocks[i], cnts[i]);
+  for (i = 1; i < BLOCK_CNT; i += 2)
+    palloc_free_multiple (blocks[i], cnts[i]);
+  msg ("freed all blocks.");
+
+  /* Take the whole pool, largest blocks first.  The first order
+     that yields a block is the largest the pool can hand out. */
+  for (order = MAX_ORDER; order >= 0; order--)
+    if (exhaust ((size_t) 1 << order, &list) > 0 && max_order < 0)
+      max_order = order;
+  if (max_order < 0)
+    fail ("could not allocate any pages");
+  free_chunks (list);
+  list = NULL;
+  msg ("exhausted the kernel pool.");
+
+  /* Take it again one page at a time, then free every other page
+     before the rest, so that each free leaves a hole next to a
+     page that is still in use. */
+  exhaust (1, &list);
+  for (i = 0; list != NULL; i++)
+    {
+      struct chunk *c = list;
+      list = c->next;
+      if (i % 2 == 0)
+        palloc_free_page (c);
+      else
+        {
+          c->next = odd;
+          odd = c;
+        }
+    }
+  free_chunks (odd);
+  msg ("freed the pool one page at a time.");
+
+  big_pages = (size_t) 1 << max_order;
+  big = palloc_get_multiple (PAL_ZERO, big_pages);
+  if (big == NULL)
+    fail ("free pages were not merged into a block of %zu pages", big_pages);
+  for (j = 0; j < (int) (big_pages * PGSIZE); j += PGSIZE)
+    if (big[j] != 0)
+      fail ("PAL_ZERO block not zeroed at offset %d", j);
+  palloc_free_multiple (big, big_pages);
+  msg ("allocated and freed the largest block again.");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-buddy) begin
+(palloc-buddy) allocated 24 blocks.
+(palloc-buddy) blocks do not overlap.
+(palloc-buddy) freed all blocks.
+(palloc-buddy) exhausted the kernel pool.
+(palloc-buddy) freed the pool one page at a time.
+(palloc-buddy) allocated and freed the largest block again.
+(palloc-buddy) end
+EOF
+pass;
@@ -0,0 +1,99 @@
+/* Exercises the slab allocator.  Creates a cache with a
+   constructor, checks that objects are packed at their exact size,
+   allocates enough of them to need several slabs, and checks that
+   they are constructed and do not overlap.  Then frees them all,
+   checks that the slabs can be given back, and that a recycled
+   object keeps its constructed state. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
+
+#define OBJ_CNT 300
+#define CTOR_MAGIC 0x1234abcd
+
+struct obj
+  {
+    unsigned magic;             /* Set by the constructor. */
+    int id;                     /* Set by the test. */
+    char pad[32];
+  };
+
+static void
+obj_ctor (void *p)
+{
+  struct obj *o = p;
+  o->magic = CTOR_MAGIC;
+  o->id = -1;
+}
+
+void
+test_slab_cache (void) 
+{
+  static struct obj *objs[OBJ_CNT];
+  struct kmem_cache *cache, *zcache;
+  struct obj *o;
+  size_t per_slab;
+  int *z;
+  int i;
+
+  cache = kmem_cache_create ("slab-cache", sizeof (struct obj), 0, obj_ctor);
+  if (cache == NULL)
+    fail ("kmem_cache_create failed");
+
+  per_slab = kmem_cache_objs_per_slab (cache);
+  if (per_slab * sizeof (struct obj) < PGSIZE * 7 / 8)
+    fail ("only %zu objects of %zu bytes per slab",
+          per_slab, sizeof (struct obj));
+  msg ("objects are packed at their exact size.");
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i] = kmem_cache_alloc (cache);
+      if (objs[i] == NULL)
+        fail ("allocation %d failed", i);
+      if (objs[i]->magic != CTOR_MAGIC || objs[i]->id != -1)
+        fail ("object %d was not constructed", i);
+      objs[i]->id = i;
+      memset (objs[i]->pad, i, sizeof objs[i]->pad);
+    }
+  if (kmem_cache_slabs (cache) < OBJ_CNT / per_slab)
+    fail ("%d objects in only %zu slabs", OBJ_CNT, kmem_cache_slabs (cache));
+  msg ("allocated %d objects.", OBJ_CNT);
+
+  for (i = 0; i < OBJ_CNT; i++)
+    if (objs[i]->id != i || objs[i]->pad[sizeof objs[i]->pad - 1] != (char) i)
+      fail ("object %d overwritten", i);
+  msg ("objects do not overlap.");
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i]->id = -1;
+      kmem_cache_free (cache, objs[i]);
+    }
+  kmem_cache_shrink (cache);
+  if (kmem_cache_slabs (cache) != 0)
+    fail ("%zu slabs left after shrinking", kmem_cache_slabs (cache));
+  msg ("freed all objects and slabs.");
+
+  o = kmem_cache_alloc (cache);
+  o->id = 42;
+  kmem_cache_free (cache, o);
+  o = kmem_cache_alloc (cache);
+  if (o->magic != CTOR_MAGIC || o->id != 42)
+    fail ("recycled object lost its state");
+  kmem_cache_free (cache, o);
+  kmem_cache_destroy (cache);
+  msg ("recycled objects keep their state.");
+
+  zcache = kmem_cache_create ("slab-zero", sizeof (int) * 3, 0, NULL);
+  z = kmem_cache_zalloc (zcache);
+  if (z == NULL || z[0] != 0 || z[1] != 0 || z[2] != 0)
+    fail ("kmem_cache_zalloc did not clear the object");
+  kmem_cache_free (zcache, z);
+  kmem_cache_destroy (zcache);
+  msg ("zeroed allocation works.");
+}
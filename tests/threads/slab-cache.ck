@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab-cache) begin
+(slab-cache) objects are packed at their exact size.
+(slab-cache) allocated 300 objects.
+(slab-cache) objects do not overlap.
+(slab-cache) freed all objects and slabs.
+(slab-cache) recycled objects keep their state.
+(slab-cache) zeroed allocation works.
+(slab-cache) end
+EOF
+pass;
@@ -0,0 +1,101 @@
+/* Builds a chain of NESTING threads under the stride scheduler,
+   each holding one lock and waiting for the lock of the thread
+   before it, with the main thread holding the first lock.  Every
+   thread in the chain must have lent its tickets all the way to
+   the main thread, however long the chain, and every loan must
+   be paid back exactly as the locks are released. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define NESTING 10
+#define TICKETS 10
+
+struct chain_info
+  {
+    int level;
+    struct thread *self;
+    int donated_holding;                /* After taking both locks. */
+    int donated_released;               /* After releasing them. */
+  };
+
+static thread_func chain_thread;
+static struct lock locks[NESTING + 1];
+static struct chain_info info[NESTING + 1];
+static struct semaphore done_sema;
+
+void
+test_stride_donate_chain (void)
+{
+  struct thread *curr = thread_current ();
+  int i;
+
+  ASSERT (thread_stride);
+
+  sema_init (&done_sema, 0);
+  for (i = 0; i <= NESTING; i++)
+    lock_init (&locks[i]);
+  lock_acquire (&locks[0]);
+
+  for (i = 1; i <= NESTING; i++)
+    {
+      char name[16];
+
+      info[i].level = i;
+      info[i].self = NULL;
+      snprintf (name, sizeof name, "chain %d", i);
+      thread_create (name, PRI_DEFAULT, chain_thread, &info[i]);
+
+      /* Let the new thread block on the previous lock. */
+      while (info[i].self == NULL || info[i].self->wait_on_lock == NULL)
+        thread_yield ();
+    }
+
+  for (i = 1; i <= NESTING; i++)
+    if (info[i].self->donated_tickets != (NESTING - i) * TICKETS)
+      fail ("chain %d holds %d donated tickets, expected %d", i,
+            info[i].self->donated_tickets, (NESTING - i) * TICKETS);
+  if (curr->donated_tickets != NESTING * TICKETS)
+    fail ("main thread holds %d donated tickets, expected %d",
+          curr->donated_tickets, NESTING * TICKETS);
+  msg ("Main thread received tickets from all %d threads.", NESTING);
+
+  lock_release (&locks[0]);
+  if (curr->donated_tickets != 0)
+    fail ("main thread kept %d donated tickets", curr->donated_tickets);
+
+  for (i = 1; i <= NESTING; i++)
+    sema_down (&done_sema);
+  for (i = 1; i <= NESTING; i++)
+    {
+      if (info[i].donated_holding != (NESTING - i) * TICKETS)
+        fail ("chain %d held %d donated tickets with both locks, "
+              "expected %d", i, info[i].donated_holding,
+              (NESTING - i) * TICKETS);
+      if (info[i].donated_released != 0)
+        fail ("chain %d kept %d donated tickets", i,
+              info[i].donated_released);
+    }
+  msg ("All donated tickets were returned.");
+}
+
+static void
+chain_thread (void *info_)
+{
+  struct chain_info *info = info_;
+  struct thread *curr = thread_current ();
+
+  thread_set_tickets (TICKETS);
+  lock_acquire (&locks[info->level]);
+  info->self = curr;
+  lock_acquire (&locks[info->level - 1]);
+
+  info->donated_holding = curr->donated_tickets;
+  lock_release (&locks[info->level]);
+  lock_release (&locks[info->level - 1]);
+  info->donated_released = curr->donated_tickets;
+  sema_up (&done_sema);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(stride-donate-chain) begin
+(stride-donate-chain) Main thread received tickets from all 10 threads.
+(stride-donate-chain) All donated tickets were returned.
+(stride-donate-chain) end
+EOF
+pass;
@@ -0,0 +1,90 @@
+/* Runs three CPU-bound threads holding 100, 200 and 300 tickets
+   under the stride scheduler for 10 seconds.  Each thread counts
+   the timer ticks during which it ran; their shares of the total
+   should follow the 1:2:3 ticket ratio to within 5 percentage
+   points. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 3
+#define TOLERANCE 5                     /* Percentage points. */
+
+struct share_info
+  {
+    int64_t start_time;
+    int tickets;
+    int tick_count;
+  };
+
+static thread_func load_thread;
+static struct semaphore done_sema;
+
+void
+test_stride_share (void)
+{
+  struct share_info info[THREAD_CNT];
+  int64_t start_time;
+  int total_tickets = 0, total_ticks = 0;
+  int i;
+
+  ASSERT (thread_stride);
+
+  sema_init (&done_sema, 0);
+  start_time = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+
+      info[i].start_time = start_time;
+      info[i].tickets = 100 * (i + 1);
+      info[i].tick_count = 0;
+      total_tickets += info[i].tickets;
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, &info[i]);
+    }
+  msg ("Sleeping 12 seconds to let threads run, please wait...");
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done_sema);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    total_ticks += info[i].tick_count;
+  if (total_ticks == 0)
+    fail ("threads received no ticks");
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      int expected = 100 * info[i].tickets / total_tickets;
+      int actual = 100 * info[i].tick_count / total_ticks;
+
+      if (actual < expected - TOLERANCE || actual > expected + TOLERANCE)
+        fail ("thread %d with %d tickets got %d%% of %d ticks, "
+              "expected %d%%", i, info[i].tickets, actual, total_ticks,
+              expected);
+      msg ("Thread %d with %d tickets got its share.", i, info[i].tickets);
+    }
+}
+
+static void
+load_thread (void *info_)
+{
+  struct share_info *info = info_;
+  int64_t sleep_time = 1 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 10 * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  thread_set_tickets (info->tickets);
+  timer_sleep (sleep_time - timer_elapsed (info->start_time));
+  while (timer_elapsed (info->start_time) < spin_time)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        info->tick_count++;
+      last_time = cur_time;
+    }
+  sema_up (&done_sema);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(stride-share) begin
+(stride-share) Sleeping 12 seconds to let threads run, please wait...
+(stride-share) Thread 0 with 100 tickets got its share.
+(stride-share) Thread 1 with 200 tickets got its share.
+(stride-share) Thread 2 with 300 tickets got its share.
+(stride-share) end
+EOF
+pass;
@@ -0,0 +1,62 @@
+/* Measures the cost of a thread switch by having two threads of
+   equal priority hand a pair of semaphores back and forth.  Each
+   round trip blocks and wakes both threads once, so it costs two
+   context switches.  The timing is printed without the test-name
+   prefix because it varies from run to run; only the round-trip
+   count is checked. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ROUND_TRIPS 20000
+
+static thread_func pong_thread;
+static struct semaphore ping, pong, done;
+static int pong_cnt;
+
+void
+test_switch_pingpong (void) 
+{
+  int64_t start, elapsed;
+  int i;
+
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  sema_init (&done, 0);
+  pong_cnt = 0;
+
+  thread_create ("pong", PRI_DEFAULT, pong_thread, NULL);
+
+  start = timer_ticks ();
+  for (i = 0; i < ROUND_TRIPS; i++) 
+    {
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  elapsed = timer_elapsed (start);
+  sema_down (&done);
+
+  msg ("%d round trips completed.", pong_cnt);
+  printf ("switch-pingpong: %d switches in %"PRId64" ticks, ~%"PRId64" ns each\n",
+          2 * ROUND_TRIPS, elapsed,
+          elapsed * (1000000000 / TIMER_FREQ) / (2 * ROUND_TRIPS));
+}
+
+static void
+pong_thread (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ROUND_TRIPS; i++) 
+    {
+      sema_down (&ping);
+      pong_cnt++;
+      sema_up (&pong);
+    }
+  sema_up (&done);
+}
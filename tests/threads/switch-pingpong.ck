@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^switch-pingpong: \d+ switches in \d+ ticks/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(switch-pingpong) begin
+(switch-pingpong) 20000 round trips completed.
+(switch-pingpong) end
+EOF
+pass;
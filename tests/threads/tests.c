@@ -29,6 +29,14 @@ static const struct test tests[] =
         {"priority-preempt", test_priority_preempt},
         {"priority-sema", test_priority_sema},
         {"priority-condvar", test_priority_condvar},
+        {"edf-load", test_edf_load},
+        {"switch-pingpong", test_switch_pingpong},
+        {"fpu-lazy", test_fpu_lazy},
+        {"palloc-buddy", test_palloc_buddy},
+        {"slab-cache", test_slab_cache},
+        {"malloc-bench", test_malloc_bench},
+        {"stride-share", test_stride_share},
+        {"stride-donate-chain", test_stride_donate_chain},
         {"mlfqs-load-1", test_mlfqs_load_1},
         {"mlfqs-load-60", test_mlfqs_load_60},
         {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -0,0 +1,39 @@
+/* Touches one byte in every 4 kB page of a 4 MB zero-filled
+   buffer, many times over.  With 4 kB pages each touch needs its
+   own TLB entry, far more than the TLB holds; run with -ulpage,
+   the buffer is covered by two 2 MB pages.  Compare the run times
+   of the two configurations to see the difference. */
+
+#include <stdint.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (4 * 1024 * 1024)          /* Buffer size. */
+#define STRIDE 4096                     /* Bytes between touches. */
+#define PASSES 64                       /* Read passes over BUF. */
+
+static unsigned char buf[SIZE] __attribute__ ((aligned (2 * 1024 * 1024)));
+
+void
+test_main (void)
+{
+  uint64_t sum = 0;
+  size_t i;
+  int pass;
+
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != 0)
+      fail ("byte %zu is %d, not zero", i, buf[i]);
+  msg ("buffer is zeroed");
+
+  for (i = 0; i < SIZE / STRIDE; i++)
+    buf[i * STRIDE] = (unsigned char) i;
+
+  for (pass = 0; pass < PASSES; pass++)
+    for (i = 0; i < SIZE / STRIDE; i++)
+      sum += buf[i * STRIDE];
+
+  if (sum != (uint64_t) PASSES * 4 * 32640)
+    fail ("sum is %llu", (unsigned long long) sum);
+  msg ("%d passes of %d pages", PASSES, SIZE / STRIDE);
+}
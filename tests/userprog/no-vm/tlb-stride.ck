@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(tlb-stride) begin
+(tlb-stride) buffer is zeroed
+(tlb-stride) 64 passes of 1024 pages
+(tlb-stride) end
+EOF
+pass;
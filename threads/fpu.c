@@ -0,0 +1,220 @@
+#include "threads/fpu.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "intrinsic.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+
+/* Control register bits.  See [IA32-v3a] 2.5 "Control Registers". */
+#define CR0_MP (1 << 1)			/* Monitor coprocessor. */
+#define CR0_EM (1 << 2)			/* x87 emulation. */
+#define CR0_TS (1 << 3)			/* Task switched. */
+#define CR4_OSFXSR (1 << 9)		/* OS supports FXSAVE/FXRSTOR. */
+#define CR4_OSXMMEXCPT (1 << 10) /* OS handles #XF. */
+
+#define FPU_AREA_SIZE 512		/* Size of the FXSAVE area. */
+#define FPU_AREA_ALIGN 16		/* FXSAVE area must be 16-byte aligned. */
+#define MXCSR_DEFAULT 0x1f80	/* All SIMD exceptions masked. */
+
+/* The FXSAVE area of T, rounded up inside its malloc() block. */
+#define FPU_AREA(T) ((void *)ROUND_UP((uintptr_t)(T)->fpu_state, FPU_AREA_ALIGN))
+
+static struct thread *fpu_owner; /* FPU 레지스터에 상태가 올라가 있는 쓰레드 */
+static bool fpu_ts;				 /* CR0.TS가 켜져 있는지 여부 */
+
+/* Statistics. */
+static long long fpu_faults;   /* # of #NM faults. */
+static long long fpu_saves;	   /* # of FXSAVEs. */
+static long long fpu_restores; /* # of FXRSTORs. */
+
+static intr_handler_func fpu_nm_handler;
+
+static void
+fxsave(void *area)
+{
+	__asm __volatile("fxsave64 (%0)" : : "r"(area) : "memory");
+}
+
+static void
+fxrstor(void *area)
+{
+	__asm __volatile("fxrstor64 (%0)" : : "r"(area) : "memory");
+}
+
+static void
+set_ts(bool ts)
+{
+	if (ts == fpu_ts)
+		return;
+	if (ts)
+		lcr0(rcr0() | CR0_TS);
+	else
+		clts();
+	fpu_ts = ts;
+}
+
+/* Writes the live FPU registers back to the owner's save area and
+   drops ownership, so the next FPU use by anyone faults. */
+static void
+fpu_flush(void)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (fpu_owner == NULL)
+		return;
+	set_ts(false);
+	fxsave(FPU_AREA(fpu_owner));
+	fpu_saves++;
+	fpu_owner = NULL;
+	set_ts(true);
+}
+
+static bool
+alloc_area(struct thread *t)
+{
+	if (t->fpu_state == NULL)
+		t->fpu_state = malloc(FPU_AREA_SIZE + FPU_AREA_ALIGN - 1);
+	return t->fpu_state != NULL;
+}
+
+/**
+ * @brief FPU/SSE를 켜고 #NM 핸들러를 등록하는 함수
+ *
+ * x87 에뮬레이션을 끄고 FXSAVE/SSE를 허용한 뒤 CR0.TS를 켜 두어,
+ * 처음 FPU를 쓰는 쓰레드가 #NM을 통해 상태를 받도록 한다.
+ */
+void fpu_init(void)
+{
+	lcr4(rcr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+	lcr0((rcr0() & ~CR0_EM) | CR0_MP | CR0_TS);
+	fpu_ts = true;
+
+	intr_register_int(7, 0, INTR_ON, fpu_nm_handler,
+					  "#NM Device Not Available Exception");
+}
+
+/**
+ * @brief NEXT로 문맥 교환하기 직전에 CR0.TS를 맞추는 함수
+ *
+ * NEXT가 FPU 레지스터의 소유자면 TS를 끄고, 아니면 켜서 첫 사용 때 #NM이 나게 한다.
+ * 상태를 저장하거나 복원하지는 않으므로 FPU를 쓰지 않는 쓰레드는 비용이 없다.
+ */
+void fpu_switch(struct thread *next)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	set_ts(next != fpu_owner);
+}
+
+/**
+ * @brief 종료하는 쓰레드 T의 FPU 상태를 버리는 함수
+ *
+ * T가 소유자라면 레지스터를 저장하지 않고 소유권만 놓은 뒤, 저장 공간을 해제한다.
+ */
+void fpu_release(struct thread *t)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (fpu_owner == t)
+	{
+		fpu_owner = NULL;
+		set_ts(true);
+	}
+	intr_set_level(old_level);
+
+	free(t->fpu_state);
+	t->fpu_state = NULL;
+	t->fpu_used = false;
+}
+
+/**
+ * @brief exec로 새 프로그램을 올릴 때 T의 FPU 상태를 초기 상태로 되돌리는 함수
+ */
+void fpu_reset(struct thread *t)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (fpu_owner == t)
+	{
+		fpu_owner = NULL;
+		set_ts(true);
+	}
+	t->fpu_used = false;
+	intr_set_level(old_level);
+}
+
+/**
+ * @brief fork 시 SRC의 FPU 상태를 DST로 복사하는 함수
+ *
+ * @return 저장 공간을 할당하지 못하면 false
+ */
+bool fpu_copy(struct thread *dst, struct thread *src)
+{
+	enum intr_level old_level;
+
+	if (!src->fpu_used)
+		return true;
+	if (!alloc_area(dst))
+		return false;
+
+	old_level = intr_disable();
+	if (fpu_owner == src || fpu_owner == dst)
+		fpu_flush();
+	memcpy(FPU_AREA(dst), FPU_AREA(src), FPU_AREA_SIZE);
+	dst->fpu_used = true;
+	intr_set_level(old_level);
+	return true;
+}
+
+/* Prints FPU statistics. */
+void fpu_print_stats(void)
+{
+	printf("FPU: %lld #NM faults, %lld saves, %lld restores\n",
+		   fpu_faults, fpu_saves, fpu_restores);
+}
+
+/* #NM handler: the current thread used the FPU while CR0.TS was
+   set.  Hands the FPU registers over from their previous owner.
+   Runs with interrupts on so that the save area can be allocated
+   on first use; the hand-over itself runs with interrupts off. */
+static void
+fpu_nm_handler(struct intr_frame *f UNUSED)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+
+	if (!alloc_area(curr))
+	{
+		printf("%s: out of memory for FPU state\n", thread_name());
+		curr->exit_status = -1;
+		thread_exit();
+	}
+
+	old_level = intr_disable();
+	fpu_faults++;
+	set_ts(false);
+	if (fpu_owner != curr)
+	{
+		if (fpu_owner != NULL)
+		{
+			fxsave(FPU_AREA(fpu_owner));
+			fpu_saves++;
+		}
+		if (curr->fpu_used)
+		{
+			fxrstor(FPU_AREA(curr));
+			fpu_restores++;
+		}
+		else
+		{
+			uint32_t mxcsr = MXCSR_DEFAULT;
+			__asm __volatile("fninit; ldmxcsr %0" : : "m"(mxcsr));
+			curr->fpu_used = true;
+		}
+		fpu_owner = curr;
+	}
+	intr_set_level(old_level);
+}
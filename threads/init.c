@@ -13,14 +13,20 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
+#ifdef MEMPROF
+#include "threads/memprof.h"
+#endif
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -51,11 +57,16 @@ bool power_off_when_done;
 
 bool thread_tests;
 
+/* -nolpage: Map the kernel with 4 kB pages only? */
+static bool kernel_small_pages;
+
 static void bss_init (void);
 static void paging_init (uint64_t mem_end);
 
 static char **read_command_line (void);
 static char **parse_options (char **argv);
+static void parse_slice (char *value);
+static void parse_pmag (char *value);
 static void run_actions (char **argv);
 static void usage (void);
 
@@ -84,8 +95,13 @@ main (void) {
 
 	/* Initialize memory system. */
 	mem_end = palloc_init ();
-	malloc_init ();
+#ifdef MEMPROF
+	memprof_init ();
+#endif
+	malloc_init (mem_end);
+	slab_init ();
 	paging_init (mem_end);
+	tlb_init ();
 
 #ifdef USERPROG
 	tss_init ();
@@ -94,6 +110,7 @@ main (void) {
 
 	/* Initialize interrupt handlers. */
 	intr_init ();
+	fpu_init ();
 	timer_init ();
 	kbd_init ();
 	input_init ();
@@ -103,6 +120,7 @@ main (void) {
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	workqueue_init (&system_wq, "kworker", PRI_DEFAULT, 2);
 	serial_init_queue ();
 	timer_calibrate ();
 
@@ -155,6 +173,22 @@ paging_init (uint64_t mem_end) {
 	for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
 		uint64_t va = (uint64_t) ptov(pa);
 
+		/* NOTE: [Improve] Whole 2 MB stretches get a single large
+		 * PDE, which spares their page tables and lets the TLB
+		 * cover the kernel's view of memory with far fewer
+		 * entries.  Stretches that hold kernel text, which must
+		 * stay read-only, or run past MEM_END use 4 kB pages. */
+		if (!kernel_small_pages && (pa & LPGMASK) == 0
+				&& pa + LPGSIZE <= mem_end
+				&& (va + LPGSIZE <= (uint64_t) &start
+					|| va >= (uint64_t) &_end_kernel_text)) {
+			if ((pte = pml4e_walk_pde (pml4, va, 1)) != NULL) {
+				*pte = pa | PTE_PS | PTE_P | PTE_W;
+				pa += LPGSIZE - PGSIZE;
+				continue;
+			}
+		}
+
 		perm = PTE_P | PTE_W;
 		if ((uint64_t) &start <= va && va < (uint64_t) &_end_kernel_text)
 			perm &= ~PTE_W;
@@ -221,9 +255,25 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-stride"))
+			thread_stride = true;
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
+		else if (!strcmp (name, "-tcache"))
+			thread_cache_max = atoi (value);
+		else if (!strcmp (name, "-slice"))
+			parse_slice (value);
+		else if (!strcmp (name, "-pmag"))
+			parse_pmag (value);
+		else if (!strcmp (name, "-nolpage"))
+			kernel_small_pages = true;
+		else if (!strcmp (name, "-nopcid"))
+			tlb_pcid_allowed = false;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
+		else if (!strcmp (name, "-ulpage"))
+			user_large_pages = true;
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
 #endif
@@ -231,13 +281,66 @@ parse_options (char **argv) {
 			PANIC ("unknown option `%s' (use -h for help)", name);
 	}
 
+	if (thread_mlfqs && thread_stride)
+		PANIC ("-mlfqs and -stride cannot be used together");
+
 	return argv;
 }
 
+/* Parses the value of "-slice", a comma-separated list of
+   either TICKS, which sets the time slice of every priority, or
+   PRI:TICKS, which sets the time slice of a single priority. */
+static void
+parse_slice (char *value) {
+	char *item, *save_ptr;
+
+	if (value == NULL)
+		PANIC ("-slice requires a value (use -h for help)");
+
+	for (item = strtok_r (value, ",", &save_ptr); item != NULL;
+			item = strtok_r (NULL, ",", &save_ptr)) {
+		char *colon = strchr (item, ':');
+		int priority = -1;
+		int ticks;
+
+		if (colon != NULL) {
+			*colon = '\0';
+			priority = atoi (item);
+			ticks = atoi (colon + 1);
+		} else
+			ticks = atoi (item);
+
+		if (ticks <= 0 || (colon != NULL && priority < PRI_MIN)
+				|| !thread_set_slice (priority, ticks))
+			PANIC ("bad -slice value `%s'", item);
+	}
+}
+
+/* Parses the value of "-pmag", HIGH or HIGH,BATCH, and sets the
+   page magazine watermarks.  BATCH defaults to half of
+   HIGH. */
+static void
+parse_pmag (char *value) {
+	char *comma;
+	int high, batch;
+
+	if (value == NULL)
+		PANIC ("-pmag requires a value (use -h for help)");
+
+	comma = strchr (value, ',');
+	high = atoi (value);
+	batch = comma != NULL ? atoi (comma + 1) : (high + 1) / 2;
+	if (high < 0 || batch < 0 || !palloc_set_magazine (high, batch))
+		PANIC ("bad -pmag value `%s'", value);
+}
+
 /* Runs the task specified in ARGV[1]. */
 static void
 run_task (char **argv) {
 	const char *task = argv[1];
+#ifdef MEMPROF
+	uint64_t mark = memprof_mark ();
+#endif
 
 	printf ("Executing '%s':\n", task);
 #ifdef USERPROG
@@ -250,6 +353,10 @@ run_task (char **argv) {
 	run_test (task);
 #endif
 	printf ("Execution of '%s' complete.\n", task);
+#ifdef MEMPROF
+	/* Reported after the test's output, so that checks ignore it. */
+	memprof_leaks (mark, task);
+#endif
 }
 
 /* Executes all of the actions specified in ARGV[]
@@ -326,8 +433,16 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -stride            Use stride scheduler with per-thread tickets.\n"
+			"  -tickless          Stop the timer tick while the CPU is idle.\n"
+			"  -tcache=COUNT      Keep up to COUNT dead threads' pages for reuse.\n"
+			"  -slice=[PRI:]TICKS[,...]  Set the base time slice of PRI (default: all).\n"
+			"  -pmag=HIGH[,BATCH] Set page magazine watermarks (0 disables).\n"
+			"  -nolpage           Map kernel memory with 4 kB pages only.\n"
+			"  -nopcid            Flush the whole TLB on every address space switch.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+			"  -ulpage            Map large zero-filled user segments with 2 MB pages.\n"
 #endif
 			);
 	power_off ();
@@ -354,6 +469,16 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	synch_print_stats ();
+	workqueue_print_stats ();
+	fpu_print_stats ();
+	palloc_print_stats ();
+	tlb_print_stats ();
+	malloc_print_stats ();
+	slab_print_stats ();
+#ifdef MEMPROF
+	memprof_print_stats ();
+#endif
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -1,10 +1,15 @@
 #include "threads/malloc.h"
+#include <bitmap.h>
 #include <debug.h>
 #include <list.h>
 #include <round.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
+#ifdef MEMPROF
+#include "threads/memprof.h"
+#endif
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -32,14 +37,41 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   NOTE: [Improve] Size classes are spaced by about 1.25x instead
+   of 2x, which bounds the rounding waste at 25% instead of 50%,
+   and go up to MEDIUM_MAX.  A class whose blocks would waste more
+   than 1/8 of a single-page arena, which includes every class
+   above 2 kB, is "medium": its arenas are runs of up to
+   MEDIUM_RUN_MAX contiguous pages.  A block in a medium run
+   may not share a page with the arena header, so each medium
+   block is preceded by a pointer to its arena, and every page of
+   a medium run is marked in MEDIUM_MAP so that free() knows to
+   look for that pointer.  Only requests above MEDIUM_MAX get
+   pages of their own.
+
+   An arena whose blocks are all free is not returned at once: up
+   to malloc_empty_keep of them stay on the descriptor's empty
+   list, so that a free() followed by a malloc() of the same size
+   does not round-trip through the page allocator.  The page
+   allocator calls malloc_shrink() to reclaim them when it runs
+   out of pages. */
+
+#define MEDIUM_MAX (16 * 1024)          /* Largest medium block. */
+#define MEDIUM_RUN_MAX 16               /* Most pages in a medium run. */
 
 /* Descriptor. */
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
+	size_t arena_pages;         /* Pages per arena, more than 1 if medium. */
+	size_t hdr_size;            /* Bytes in front of each block. */
 	struct list free_list;      /* List of free blocks. */
-	struct lock lock;           /* Lock. */
+	struct list empty_list;     /* Arenas with no block in use. */
+	size_t arena_cnt;           /* Number of arenas. */
+	size_t empty_cnt;           /* Number of arenas in empty_list. */
+	struct mutex_fast lock;     /* Lock. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -50,6 +82,12 @@ struct arena {
 	unsigned magic;             /* Always set to ARENA_MAGIC. */
 	struct desc *desc;          /* Owning descriptor, null for big block. */
 	size_t free_cnt;            /* Free blocks; pages in big block. */
+	struct list_elem empty_elem; /* Element in desc's empty_list. */
+};
+
+/* Header in front of each block of a medium run. */
+struct medium_hdr {
+	struct arena *arena;        /* Run that the block is in. */
 };
 
 /* Free block. */
@@ -58,31 +96,108 @@ struct block {
 };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[40];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Empty arenas kept per descriptor. */
+size_t malloc_empty_keep = 2;
+
+/* One bit per physical page: set if the page is in a medium run. */
+static struct bitmap *medium_map;
+
+/* Statistics. */
+static size_t big_pages;        /* Pages in big blocks. */
+static long long shrunk_pages;  /* Pages given back by malloc_shrink(). */
+
+static void desc_init (struct desc *, size_t block_size);
+static void *malloc_block (size_t);
+static struct arena *arena_create (struct desc *);
+static void arena_release (struct desc *, struct arena *);
+static bool is_medium (const void *);
+static void mark_medium (struct arena *, size_t page_cnt, bool);
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
 
-/* Initializes the malloc() descriptors. */
+/* Initializes the malloc() descriptors.  MEM_END is the end of
+   physical memory, as returned by palloc_init(). */
 void
-malloc_init (void) {
-	size_t block_size;
+malloc_init (uint64_t mem_end) {
+	size_t block_size = 16, next, pow2;
+	size_t page_cnt = mem_end / PGSIZE;
+	size_t map_size = bitmap_buf_size (page_cnt);
 
-	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
+	while (block_size <= MEDIUM_MAX) {
 		struct desc *d = &descs[desc_cnt++];
 		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
-		d->block_size = block_size;
-		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-		list_init (&d->free_list);
-		lock_init (&d->lock);
+		desc_init (d, block_size);
+
+		/* Next class is about 1.25 times as large, but powers of 2,
+		   which are common request sizes, always get a class. */
+		next = ROUND_UP (block_size * 5 / 4,
+				block_size < PGSIZE / 2 ? 8 : 64);
+		for (pow2 = 16; pow2 <= block_size; pow2 *= 2)
+			continue;
+		if (next + block_size / 8 > pow2)
+			next = pow2;
+		block_size = next;
 	}
+
+	medium_map = bitmap_create_in_buf (page_cnt,
+			palloc_get_multiple (PAL_ASSERT | PAL_ZERO,
+				DIV_ROUND_UP (map_size, PGSIZE)), map_size);
+	palloc_register_shrinker (malloc_shrink);
+}
+
+/* Initializes descriptor D for blocks of BLOCK_SIZE bytes.  Uses
+   the smallest arena, up to MEDIUM_RUN_MAX pages, that wastes at
+   most 1/8 of its pages, or else the one that wastes the smallest
+   fraction. */
+static void
+desc_init (struct desc *d, size_t block_size) {
+	size_t best_waste = PGSIZE, best_pages = 0;
+	size_t pages;
+
+	for (pages = 1; pages <= MEDIUM_RUN_MAX; pages++) {
+		size_t hdr = pages > 1 ? sizeof (struct medium_hdr) : 0;
+		size_t cnt = (pages * PGSIZE - sizeof (struct arena))
+			/ (block_size + hdr);
+		size_t waste = pages * PGSIZE - cnt * block_size;
+
+		if (cnt == 0)
+			continue;
+		if (best_pages == 0 || waste * best_pages < best_waste * pages) {
+			best_waste = waste;
+			best_pages = pages;
+		}
+		if (waste * 8 <= pages * PGSIZE)
+			break;
+	}
+	ASSERT (best_pages > 0);
+
+	d->block_size = block_size;
+	d->arena_pages = best_pages;
+	d->hdr_size = best_pages > 1 ? sizeof (struct medium_hdr) : 0;
+	d->blocks_per_arena = (best_pages * PGSIZE - sizeof (struct arena))
+		/ (block_size + d->hdr_size);
+	list_init (&d->free_list);
+	list_init (&d->empty_list);
+	mutex_fast_init (&d->lock);
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
    Returns a null pointer if memory is not available. */
 void *
 malloc (size_t size) {
+	void *p = malloc_block (size);
+#ifdef MEMPROF
+	memprof_alloc (MEMPROF_MALLOC, p, size, __builtin_return_address (0));
+#endif
+	return p;
+}
+
+/* Does the work of malloc(). */
+static void *
+malloc_block (size_t size) {
 	struct desc *d;
 	struct block *b;
 	struct arena *a;
@@ -100,6 +215,8 @@ malloc (size_t size) {
 		/* SIZE is too big for any descriptor.
 		   Allocate enough pages to hold SIZE plus an arena. */
 		size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
+		enum intr_level old_level;
+
 		a = palloc_get_multiple (0, page_cnt);
 		if (a == NULL)
 			return NULL;
@@ -109,37 +226,28 @@ malloc (size_t size) {
 		a->magic = ARENA_MAGIC;
 		a->desc = NULL;
 		a->free_cnt = page_cnt;
+		old_level = intr_disable ();
+		big_pages += page_cnt;
+		intr_set_level (old_level);
 		return a + 1;
 	}
 
-	lock_acquire (&d->lock);
+	mutex_fast_acquire (&d->lock);
 
 	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
-		size_t i;
-
-		/* Allocate a page. */
-		a = palloc_get_page (0);
-		if (a == NULL) {
-			lock_release (&d->lock);
-			return NULL;
-		}
-
-		/* Initialize arena and add its blocks to the free list. */
-		a->magic = ARENA_MAGIC;
-		a->desc = d;
-		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
-			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
-		}
+	if (list_empty (&d->free_list) && arena_create (d) == NULL) {
+		mutex_fast_release (&d->lock);
+		return NULL;
 	}
 
 	/* Get a block from free list and return it. */
 	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
 	a = block_to_arena (b);
-	a->free_cnt--;
-	lock_release (&d->lock);
+	if (a->free_cnt-- == d->blocks_per_arena) {
+		list_remove (&a->empty_elem);
+		d->empty_cnt--;
+	}
+	mutex_fast_release (&d->lock);
 	return b;
 }
 
@@ -156,9 +264,12 @@ calloc (size_t a, size_t b) {
 		return NULL;
 
 	/* Allocate and zero memory. */
-	p = malloc (size);
+	p = malloc_block (size);
 	if (p != NULL)
 		memset (p, 0, size);
+#ifdef MEMPROF
+	memprof_alloc (MEMPROF_MALLOC, p, size, __builtin_return_address (0));
+#endif
 
 	return p;
 }
@@ -185,7 +296,11 @@ realloc (void *old_block, size_t new_size) {
 		free (old_block);
 		return NULL;
 	} else {
-		void *new_block = malloc (new_size);
+		void *new_block = malloc_block (new_size);
+#ifdef MEMPROF
+		memprof_alloc (MEMPROF_MALLOC, new_block, new_size,
+				__builtin_return_address (0));
+#endif
 		if (old_block != NULL && new_block != NULL) {
 			size_t old_size = block_size (old_block);
 			size_t min_size = new_size < old_size ? new_size : old_size;
@@ -200,6 +315,9 @@ realloc (void *old_block, size_t new_size) {
    malloc(), calloc(), or realloc(). */
 void
 free (void *p) {
+#ifdef MEMPROF
+	memprof_free (MEMPROF_MALLOC, p);
+#endif
 	if (p != NULL) {
 		struct block *b = p;
 		struct arena *a = block_to_arena (b);
@@ -213,36 +331,161 @@ free (void *p) {
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
+			mutex_fast_acquire (&d->lock);
 
 			/* Add block to free list. */
 			list_push_front (&d->free_list, &b->free_elem);
 
-			/* If the arena is now entirely unused, free it. */
+			/* If the arena is now entirely unused, keep it for
+			   reuse or free it. */
 			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
 				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
-				palloc_free_page (a);
+				if (d->empty_cnt < malloc_empty_keep) {
+					list_push_front (&d->empty_list, &a->empty_elem);
+					d->empty_cnt++;
+				} else
+					arena_release (d, a);
 			}
 
-			lock_release (&d->lock);
+			mutex_fast_release (&d->lock);
 		} else {
 			/* It's a big block.  Free its pages. */
+			enum intr_level old_level = intr_disable ();
+			big_pages -= a->free_cnt;
+			intr_set_level (old_level);
 			palloc_free_multiple (a, a->free_cnt);
 			return;
 		}
 	}
 }
-
+
+/* Gives every empty arena back to the page allocator and returns
+   the number of pages released.  Descriptors that are locked,
+   possibly by the caller itself, are skipped.  Never sleeps. */
+size_t
+malloc_shrink (void) {
+	size_t released = 0;
+	struct desc *d;
+
+	for (d = descs; d < descs + desc_cnt; d++) {
+		if (list_empty (&d->empty_list)
+				|| mutex_fast_held_by_current_thread (&d->lock)
+				|| !mutex_fast_try_acquire (&d->lock))
+			continue;
+		while (!list_empty (&d->empty_list)) {
+			struct arena *a = list_entry (list_pop_front (&d->empty_list),
+					struct arena, empty_elem);
+			d->empty_cnt--;
+			arena_release (d, a);
+			released += d->arena_pages;
+		}
+		mutex_fast_release (&d->lock);
+	}
+	shrunk_pages += released;
+	return released;
+}
+
+/* Returns the number of pages that malloc() currently holds. */
+size_t
+malloc_pages (void) {
+	size_t pages = big_pages;
+	struct desc *d;
+
+	for (d = descs; d < descs + desc_cnt; d++)
+		pages += d->arena_cnt * d->arena_pages;
+	return pages;
+}
+
+/* Prints malloc() statistics. */
+void
+malloc_print_stats (void) {
+	size_t small = 0, medium = 0, empty = 0;
+	struct desc *d;
+
+	for (d = descs; d < descs + desc_cnt; d++) {
+		size_t pages = d->arena_cnt * d->arena_pages;
+		if (d->arena_pages > 1)
+			medium += pages;
+		else
+			small += pages;
+		empty += d->empty_cnt * d->arena_pages;
+	}
+	printf ("Malloc: %zu small, %zu medium, %zu big pages "
+			"(%zu in empty arenas), %lld pages shrunk\n",
+			small, medium, big_pages, empty, shrunk_pages);
+}
+
+/* Creates a new arena for descriptor D, with all its blocks on
+   D's free list, and puts it on D's empty list.  Returns a null
+   pointer if memory is not available.  D's lock must be held. */
+static struct arena *
+arena_create (struct desc *d) {
+	struct arena *a;
+	size_t i;
+
+	a = palloc_get_multiple (0, d->arena_pages);
+	if (a == NULL)
+		return NULL;
+
+	a->magic = ARENA_MAGIC;
+	a->desc = d;
+	a->free_cnt = d->blocks_per_arena;
+	if (d->arena_pages > 1)
+		mark_medium (a, d->arena_pages, true);
+	for (i = 0; i < d->blocks_per_arena; i++) {
+		struct block *b = arena_to_block (a, i);
+		if (d->hdr_size > 0)
+			((struct medium_hdr *) b - 1)->arena = a;
+		list_push_back (&d->free_list, &b->free_elem);
+	}
+	list_push_front (&d->empty_list, &a->empty_elem);
+	d->empty_cnt++;
+	d->arena_cnt++;
+	return a;
+}
+
+/* Removes the blocks of arena A, which must be entirely unused
+   and not on D's empty list, from D's free list and gives A back
+   to the page allocator.  D's lock must be held. */
+static void
+arena_release (struct desc *d, struct arena *a) {
+	size_t i;
+
+	ASSERT (a->free_cnt == d->blocks_per_arena);
+	for (i = 0; i < d->blocks_per_arena; i++) {
+		struct block *b = arena_to_block (a, i);
+		list_remove (&b->free_elem);
+	}
+	if (d->arena_pages > 1)
+		mark_medium (a, d->arena_pages, false);
+	d->arena_cnt--;
+	palloc_free_multiple (a, d->arena_pages);
+}
+
+/* Returns true if P lies in a medium run. */
+static bool
+is_medium (const void *p) {
+	return bitmap_test (medium_map, pg_no (vtop (p)));
+}
+
+/* Sets the MEDIUM_MAP bits of the PAGE_CNT pages starting at
+   PAGES to VALUE. */
+static void
+mark_medium (struct arena *pages, size_t page_cnt, bool value) {
+	enum intr_level old_level = intr_disable ();
+	bitmap_set_multiple (medium_map, pg_no (vtop (pages)), page_cnt, value);
+	intr_set_level (old_level);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b) {
-	struct arena *a = pg_round_down (b);
+	struct arena *a;
+
+	if (is_medium (b))
+		a = ((struct medium_hdr *) b - 1)->arena;
+	else
+		a = pg_round_down (b);
 
 	/* Check that the arena is valid. */
 	ASSERT (a != NULL);
@@ -250,7 +493,8 @@ block_to_arena (struct block *b) {
 
 	/* Check that the block is properly aligned for the arena. */
 	ASSERT (a->desc == NULL
-			|| (pg_ofs (b) - sizeof *a) % a->desc->block_size == 0);
+			|| ((uint8_t *) b - (uint8_t *) (a + 1) - a->desc->hdr_size)
+			% (a->desc->block_size + a->desc->hdr_size) == 0);
 	ASSERT (a->desc != NULL || pg_ofs (b) == sizeof *a);
 
 	return a;
@@ -264,5 +508,6 @@ arena_to_block (struct arena *a, size_t idx) {
 	ASSERT (idx < a->desc->blocks_per_arena);
 	return (struct block *) ((uint8_t *) a
 			+ sizeof *a
-			+ idx * a->desc->block_size);
+			+ idx * (a->desc->block_size + a->desc->hdr_size)
+			+ a->desc->hdr_size);
 }
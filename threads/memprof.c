@@ -0,0 +1,279 @@
+#include "threads/memprof.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+#ifdef MEMPROF
+
+/* Kernel memory profiler.
+
+   Each live allocation has a record, found through a hash table
+   keyed by address, that remembers its size, the thread that
+   made it, a sequence number, and its call site.  Call sites are
+   kept in a small open-addressing table with running totals:
+   calls, blocks and bytes outstanding, and peak bytes.
+
+   Records come from a fixed array of pages taken at boot, so that
+   the profiler never calls the allocators it watches.  When they
+   run out, further allocations are counted as untracked.
+
+   memprof_mark() and memprof_leaks() bracket a piece of work: the
+   latter reports every allocation made since the mark that is
+   still outstanding.  run_task() uses them around each test. */
+
+#define RECORD_PAGES 64                 /* Pages of allocation records. */
+#define BUCKET_CNT 1024                 /* Hash buckets for records. */
+#define SITE_MAX 256                    /* Call sites tracked. */
+#define TOP_SITES 10                    /* Sites shown in statistics. */
+#define LEAKS_SHOWN 10                  /* Leaks shown by memprof_leaks(). */
+
+/* A call site. */
+struct site {
+	void *caller;                   /* Return address, or null for "other". */
+	enum memprof_kind kind;         /* Allocator called. */
+	long long calls;                /* # of allocations. */
+	size_t cur_cnt;                 /* # of allocations outstanding. */
+	size_t cur_bytes;               /* Bytes outstanding. */
+	size_t peak_bytes;              /* Largest value of CUR_BYTES. */
+};
+
+/* A live allocation. */
+struct record {
+	struct record *next;            /* Next in bucket or free list. */
+	void *ptr;                      /* Address returned to the caller. */
+	size_t size;                    /* Bytes requested. */
+	enum memprof_kind kind;         /* Allocator. */
+	struct site *site;              /* Call site. */
+	tid_t tid;                      /* Thread that allocated. */
+	uint64_t seq;                   /* Sequence number. */
+};
+
+/* Totals for one allocator. */
+struct kind_stats {
+	size_t cur_cnt;                 /* # of allocations outstanding. */
+	size_t cur_bytes;               /* Bytes outstanding. */
+	size_t peak_bytes;              /* Largest value of CUR_BYTES. */
+	long long untracked;            /* Allocations without a record. */
+};
+
+static const char *kind_names[MEMPROF_KIND_CNT] = {"malloc", "palloc"};
+
+/* Everything below is only touched with interrupts off. */
+static bool memprof_enabled;            /* Set once records exist. */
+static struct record *buckets[BUCKET_CNT];
+static struct record *free_records;
+static struct site sites[SITE_MAX];
+static struct site other_site;          /* Used when SITES is full. */
+static struct kind_stats kinds[MEMPROF_KIND_CNT];
+static uint64_t next_seq;
+
+static struct site *find_site (void *caller, enum memprof_kind);
+static struct record **find_record (void *ptr);
+
+/* Initializes the profiler.  Must be called after palloc_init(). */
+void
+memprof_init (void) {
+	struct record *records;
+	size_t i, cnt = RECORD_PAGES * PGSIZE / sizeof *records;
+
+	records = palloc_get_multiple (PAL_ASSERT, RECORD_PAGES);
+	for (i = 0; i < cnt; i++) {
+		records[i].next = free_records;
+		free_records = &records[i];
+	}
+	memprof_enabled = true;
+}
+
+/* Records that CALLER obtained SIZE bytes at P from allocator
+   KIND.  Does nothing if P is a null pointer. */
+void
+memprof_alloc (enum memprof_kind kind, void *p, size_t size, void *caller) {
+	enum intr_level old_level;
+	struct record *r;
+	struct site *s;
+
+	if (!memprof_enabled || p == NULL)
+		return;
+
+	old_level = intr_disable ();
+	r = free_records;
+	if (r != NULL) {
+		struct record **bucket = &buckets[((uintptr_t) p >> 4) % BUCKET_CNT];
+
+		free_records = r->next;
+		s = find_site (caller, kind);
+		r->ptr = p;
+		r->size = size;
+		r->kind = kind;
+		r->site = s;
+		r->tid = thread_current ()->tid;
+		r->seq = next_seq++;
+		r->next = *bucket;
+		*bucket = r;
+
+		s->calls++;
+		s->cur_cnt++;
+		s->cur_bytes += size;
+		if (s->cur_bytes > s->peak_bytes)
+			s->peak_bytes = s->cur_bytes;
+		kinds[kind].cur_cnt++;
+		kinds[kind].cur_bytes += size;
+		if (kinds[kind].cur_bytes > kinds[kind].peak_bytes)
+			kinds[kind].peak_bytes = kinds[kind].cur_bytes;
+	} else
+		kinds[kind].untracked++;
+	intr_set_level (old_level);
+}
+
+/* Records that P, obtained from allocator KIND, was freed.
+   Allocations made before memprof_init() or without a record
+   are ignored. */
+void
+memprof_free (enum memprof_kind kind, void *p) {
+	enum intr_level old_level;
+	struct record **rp;
+
+	if (!memprof_enabled || p == NULL)
+		return;
+
+	old_level = intr_disable ();
+	rp = find_record (p);
+	if (*rp != NULL && (*rp)->kind == kind) {
+		struct record *r = *rp;
+		struct site *s = r->site;
+
+		*rp = r->next;
+		s->cur_cnt--;
+		s->cur_bytes -= r->size;
+		kinds[kind].cur_cnt--;
+		kinds[kind].cur_bytes -= r->size;
+		r->next = free_records;
+		free_records = r;
+	}
+	intr_set_level (old_level);
+}
+
+/* Returns a mark for memprof_leaks(). */
+uint64_t
+memprof_mark (void) {
+	return next_seq;
+}
+
+/* Reports the allocations made since MARK that are still
+   outstanding, under the heading NAME, and returns how many there
+   are.  Pages of threads that are still exiting may show up. */
+size_t
+memprof_leaks (uint64_t mark, const char *name) {
+	struct record shown[LEAKS_SHOWN];
+	size_t cnt = 0, bytes = 0, i;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	for (i = 0; i < BUCKET_CNT; i++) {
+		struct record *r;
+
+		for (r = buckets[i]; r != NULL; r = r->next)
+			if (r->seq >= mark) {
+				if (cnt < LEAKS_SHOWN)
+					shown[cnt] = *r;
+				cnt++;
+				bytes += r->size;
+			}
+	}
+	intr_set_level (old_level);
+
+	if (cnt == 0)
+		return 0;
+	printf ("Memprof: %zu allocations (%zu bytes) from '%s' outstanding\n",
+			cnt, bytes, name);
+	for (i = 0; i < cnt && i < LEAKS_SHOWN; i++)
+		printf ("Memprof:   %zu bytes (%s) at %p from %p, thread %d\n",
+				shown[i].size, kind_names[shown[i].kind], shown[i].ptr,
+				shown[i].site->caller, shown[i].tid);
+	return cnt;
+}
+
+/* Prints totals for each allocator and the call sites with the
+   most bytes outstanding. */
+void
+memprof_print_stats (void) {
+	struct site top[TOP_SITES];
+	struct kind_stats k[MEMPROF_KIND_CNT];
+	size_t top_cnt = 0, i;
+	enum intr_level old_level;
+
+	/* Copy what we print, since printf() may sleep. */
+	old_level = intr_disable ();
+	memcpy (k, kinds, sizeof k);
+	for (i = 0; i <= SITE_MAX; i++) {
+		struct site *s = i < SITE_MAX ? &sites[i] : &other_site;
+		size_t j;
+
+		if (s->calls == 0)
+			continue;
+
+		/* Insert S into TOP, largest CUR_BYTES first. */
+		for (j = top_cnt; j > 0 && top[j - 1].cur_bytes < s->cur_bytes; j--)
+			if (j < TOP_SITES)
+				top[j] = top[j - 1];
+		if (j < TOP_SITES) {
+			top[j] = *s;
+			if (top_cnt < TOP_SITES)
+				top_cnt++;
+		}
+	}
+	intr_set_level (old_level);
+
+	for (i = 0; i < MEMPROF_KIND_CNT; i++)
+		printf ("Memprof: %s: %zu bytes outstanding in %zu allocations, "
+				"peak %zu bytes, %lld untracked\n",
+				kind_names[i], k[i].cur_bytes, k[i].cur_cnt,
+				k[i].peak_bytes, k[i].untracked);
+	for (i = 0; i < top_cnt; i++)
+		printf ("Memprof: %p %s: %lld calls, %zu bytes outstanding "
+				"in %zu, peak %zu bytes\n",
+				top[i].caller, kind_names[top[i].kind], top[i].calls,
+				top[i].cur_bytes, top[i].cur_cnt, top[i].peak_bytes);
+}
+
+/* Returns the site for calls to allocator KIND from CALLER,
+   creating it if needed.  Interrupts must be off. */
+static struct site *
+find_site (void *caller, enum memprof_kind kind) {
+	size_t start = (((uintptr_t) caller >> 2) ^ kind) % SITE_MAX;
+	size_t i = start;
+
+	do {
+		struct site *s = &sites[i];
+
+		if (s->calls == 0 && s->caller == NULL) {
+			s->caller = caller;
+			s->kind = kind;
+			return s;
+		}
+		if (s->caller == caller && s->kind == kind)
+			return s;
+		i = (i + 1) % SITE_MAX;
+	} while (i != start);
+
+	return &other_site;
+}
+
+/* Returns the link that points to the record for PTR, which
+   points to a null pointer if there is none.  Interrupts must be
+   off. */
+static struct record **
+find_record (void *ptr) {
+	struct record **rp = &buckets[((uintptr_t) ptr >> 4) % BUCKET_CNT];
+
+	while (*rp != NULL && (*rp)->ptr != ptr)
+		rp = &(*rp)->next;
+	return rp;
+}
+
+#endif /* MEMPROF */
@@ -1,13 +1,62 @@
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
+/* NOTE: [Improve] TLB management.
+
+   With CR4.PCIDE set, the low 12 bits of CR3 select a process
+   context identifier (PCID), and TLB entries are tagged with the
+   PCID they were loaded under.  Loading CR3 with CR3_NOFLUSH set
+   then keeps the entries of every PCID, so switching back to an
+   address space finds its translations still cached.
+
+   The kernel hands out PCID_SLOTS PCIDs to the page tables it runs,
+   reusing them round robin.  PCID 0 belongs to base_pml4, whose
+   kernel-only mappings never change after boot.  invlpg only
+   reaches the current PCID, so a change to a page table that is
+   not loaded marks its slots stale instead, and the next load
+   flushes that PCID.  Without PCID support every CR3 load
+   flushes the TLB, as before. */
+#define CR4_PCIDE (1 << 17)             /* Enable PCIDs. */
+#define CPUID_PCID (1 << 17)            /* CPUID.1:ECX, PCIDs supported. */
+#define CR3_NOFLUSH (1ULL << 63)        /* Keep TLB entries on CR3 load. */
+#define PCID_SLOTS 8                    /* PCIDs in use, besides PCID 0. */
+
+/* A PCID. */
+struct pcid_slot {
+	uint64_t *pml4;                 /* Page table using the PCID, or null. */
+	bool stale;                     /* Must flush on next load? */
+};
+
+/* TLB state and statistics. */
+struct tlb_state {
+	struct pcid_slot slots[PCID_SLOTS]; /* slots[i] is PCID i + 1. */
+	unsigned next_slot;             /* Next slot to reuse. */
+	long long full_flushes;         /* CR3 loads that flushed the TLB. */
+	long long kept_loads;           /* CR3 loads that kept it by PCID. */
+	long long skipped_loads;        /* CR3 loads skipped as redundant. */
+	long long page_flushes;         /* Single entries flushed by invlpg. */
+};
+
+/* -nopcid: Clear to never use PCIDs. */
+bool tlb_pcid_allowed = true;
+
+static bool pcid_enabled;
+static struct tlb_state tlb;
+
+static bool pml4_is_active (uint64_t *pml4);
+static void tlb_flush_page (uint64_t *pml4, uint64_t va);
+static void pcid_invalidate (uint64_t *pml4);
+
 static uint64_t *
 pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 	int idx = PDX (va);
@@ -23,6 +72,9 @@ pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 			} else
 				return NULL;
 		}
+		/* A large leaf has no page table; the PDE is the PTE. */
+		if (pdp[idx] & PTE_PS)
+			return &pdp[idx];
 		return (uint64_t *) ptov (PTE_ADDR (pdp[idx]) + 8 * PTX (va));
 	}
 	return NULL;
@@ -88,6 +140,33 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	return pte;
 }
 
+/* Returns the table that entry IDX of TABLE points to.  If it
+ * is not present and CREATE is true, a zeroed table is allocated
+ * for it; otherwise a null pointer is returned. */
+static uint64_t *
+next_level (uint64_t *table, int idx, int create) {
+	if (!(table[idx] & PTE_P)) {
+		uint64_t *new_page;
+
+		if (!create || (new_page = palloc_get_page (PAL_ZERO)) == NULL)
+			return NULL;
+		table[idx] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+	}
+	return ptov (PTE_ADDR (table[idx]));
+}
+
+/* NOTE: [Improve] Returns the address of the page directory entry
+ * for virtual address VA in PML4, which is where a 2 MB mapping
+ * of VA goes.  The upper tables are created if CREATE is true;
+ * otherwise a null pointer is returned if they are missing. */
+uint64_t *
+pml4e_walk_pde (uint64_t *pml4, const uint64_t va, int create) {
+	uint64_t *pdp = next_level (pml4, PML4 (va), create);
+	uint64_t *pd = pdp != NULL ? next_level (pdp, PDPE (va), create) : NULL;
+
+	return pd != NULL ? &pd[PDX (va)] : NULL;
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -122,10 +201,18 @@ pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
-					pml4_index, pdp_index, i))
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS) {
+			/* Large leaf: FUNC sees its PDE once. */
+			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
+								 ((uint64_t) pdp_index << PDPESHIFT) |
+								 ((uint64_t) i << PDXSHIFT));
+			if (!func (&pdp[i], va, aux))
 				return false;
+		} else if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
+					pml4_index, pdp_index, i))
+			return false;
 	}
 	return true;
 }
@@ -169,7 +256,11 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS)
+			palloc_free_multiple ((void *) PDE_ADDR (pte), LPG_PAGES);
+		else
 			pt_destroy (PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pdp);
@@ -191,6 +282,11 @@ pml4_destroy (uint64_t *pml4) {
 	if (pml4 == NULL)
 		return;
 	ASSERT (pml4 != base_pml4);
+	ASSERT (!pml4_is_active (pml4));
+
+	/* A new page table at the same address must not inherit the
+	 * TLB entries of this one. */
+	pcid_invalidate (pml4);
 
 	/* if PML4 (vaddr) >= 1, it's kernel space by define. */
 	uint64_t *pdpe = ptov ((uint64_t *) pml4[0]);
@@ -199,11 +295,124 @@ pml4_destroy (uint64_t *pml4) {
 	palloc_free_page ((void *) pml4);
 }
 
+/* Enables PCIDs if the CPU supports them and -nopcid was not
+ * given.  Must be called after paging_init(), while CR3 holds
+ * base_pml4 with PCID 0. */
+void
+tlb_init (void) {
+	uint32_t eax = 1, ebx, ecx = 0, edx;
+
+	__asm __volatile ("cpuid"
+			: "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+	if (tlb_pcid_allowed && (ecx & CPUID_PCID)) {
+		lcr4 (rcr4 () | CR4_PCIDE);
+		pcid_enabled = true;
+	}
+}
+
 /* Loads page directory PD into the CPU's page directory base
- * register. */
+ * register.  Does nothing if PD is already loaded.  A null PD
+ * stands for base_pml4. */
 void
 pml4_activate (uint64_t *pml4) {
-	lcr3 (vtop (pml4 ? pml4 : base_pml4));
+	enum intr_level old_level = intr_disable ();
+	uint64_t cr3;
+
+	if (pml4 == NULL)
+		pml4 = base_pml4;
+	if (pml4_is_active (pml4)) {
+		tlb.skipped_loads++;
+		intr_set_level (old_level);
+		return;
+	}
+
+	cr3 = vtop (pml4);
+	if (!pcid_enabled)
+		tlb.full_flushes++;
+	else if (pml4 == base_pml4) {
+		cr3 |= CR3_NOFLUSH;
+		tlb.kept_loads++;
+	} else {
+		struct pcid_slot *slot = NULL;
+		unsigned i;
+
+		for (i = 0; i < PCID_SLOTS; i++)
+			if (tlb.slots[i].pml4 == pml4) {
+				slot = &tlb.slots[i];
+				break;
+			}
+		if (slot == NULL) {
+			/* Take over the next slot; its PCID may hold entries
+			 * of another page table. */
+			i = tlb.next_slot;
+			tlb.next_slot = (i + 1) % PCID_SLOTS;
+			slot = &tlb.slots[i];
+			slot->pml4 = pml4;
+			slot->stale = true;
+		}
+		cr3 |= i + 1;
+		if (slot->stale) {
+			slot->stale = false;
+			tlb.full_flushes++;
+		} else {
+			cr3 |= CR3_NOFLUSH;
+			tlb.kept_loads++;
+		}
+	}
+	lcr3 (cr3);
+	intr_set_level (old_level);
+}
+
+/* Returns true if PML4 is the page table currently loaded. */
+static bool
+pml4_is_active (uint64_t *pml4) {
+	return (rcr3 () & ~(uint64_t) PGMASK) == vtop (pml4);
+}
+
+/* Makes sure the TLB keeps no stale translation of VA in PML4
+ * after its entry has changed: by invlpg if PML4 is loaded here,
+ * otherwise by flushing its PCIDs when it is next loaded. */
+static void
+tlb_flush_page (uint64_t *pml4, uint64_t va) {
+	enum intr_level old_level = intr_disable ();
+
+	if (pml4_is_active (pml4)) {
+		invlpg (va);
+		tlb.page_flushes++;
+	}
+	intr_set_level (old_level);
+	pcid_invalidate (pml4);
+}
+
+/* Marks the PCID that holds entries of PML4 stale, unless PML4
+ * is loaded, in which case invlpg keeps it up to date. */
+static void
+pcid_invalidate (uint64_t *pml4) {
+	enum intr_level old_level;
+	int i;
+
+	if (!pcid_enabled)
+		return;
+	old_level = intr_disable ();
+	if (!pml4_is_active (pml4))
+		for (i = 0; i < PCID_SLOTS; i++)
+			if (tlb.slots[i].pml4 == pml4)
+				tlb.slots[i].stale = true;
+	intr_set_level (old_level);
+}
+
+/* Prints TLB statistics. */
+void
+tlb_print_stats (void) {
+	int64_t ticks = timer_ticks ();
+
+	printf ("TLB: %lld full flushes (%lld/s), %lld CR3 loads kept by PCID, "
+			"%lld skipped, %lld page flushes (%lld/s)%s\n",
+			tlb.full_flushes,
+			ticks > 0 ? tlb.full_flushes * TIMER_FREQ / ticks : 0,
+			tlb.kept_loads, tlb.skipped_loads, tlb.page_flushes,
+			ticks > 0 ? tlb.page_flushes * TIMER_FREQ / ticks : 0,
+			pcid_enabled ? "" : ", no PCID");
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -216,8 +425,11 @@ pml4_get_page (uint64_t *pml4, const void *uaddr) {
 
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
-	if (pte && (*pte & PTE_P))
+	if (pte && (*pte & PTE_P)) {
+		if (*pte & PTE_PS)
+			return ptov (PDE_ADDR (*pte)) + ((uint64_t) uaddr & LPGMASK);
 		return ptov (PTE_ADDR (*pte)) + pg_ofs (uaddr);
+	}
 	return NULL;
 }
 
@@ -237,16 +449,56 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 	ASSERT (pml4 != base_pml4);
 
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) upage, 1);
+	bool was_present;
+
+	/* UPAGE may not lie inside a large page. */
+	if (pte == NULL || (*pte & PTE_PS))
+		return false;
+	was_present = *pte & PTE_P;
+	*pte = vtop (kpage) | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+	if (was_present)
+		tlb_flush_page (pml4, (uint64_t) upage);
+	return true;
+}
+
+/* NOTE: [Improve] Like pml4_set_page(), but maps the 2 MB at
+ * UPAGE to the physically contiguous 2 MB at KPAGE with a single
+ * PDE.  Both must be 2 MB aligned, for KPAGE in physical memory,
+ * e.g. from palloc_get_aligned().  No 4 kB page in the range may
+ * be mapped.  Returns true if successful, false if memory
+ * allocation failed or part of the range is mapped. */
+bool
+pml4_set_large_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	uint64_t *pde, *pt;
 
-	if (pte)
-		*pte = vtop (kpage) | PTE_P | (rw ? PTE_W : 0) | PTE_U;
-	return pte != NULL;
+	ASSERT (((uint64_t) upage & LPGMASK) == 0);
+	ASSERT ((vtop (kpage) & LPGMASK) == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	pde = pml4e_walk_pde (pml4, (uint64_t) upage, 1);
+	if (pde == NULL || (*pde & PTE_PS))
+		return false;
+
+	/* An empty page table left over from earlier mappings can go. */
+	if (*pde & PTE_P) {
+		pt = ptov (PTE_ADDR (*pde));
+		for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++)
+			if (pt[i] & PTE_P)
+				return false;
+		palloc_free_page (pt);
+	}
+
+	*pde = vtop (kpage) | PTE_PS | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+	tlb_flush_page (pml4, (uint64_t) upage);
+	return true;
 }
 
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
- * UPAGE need not be mapped. */
+ * UPAGE need not be mapped.  If UPAGE lies in a large page, the
+ * whole large page becomes not present. */
 void
 pml4_clear_page (uint64_t *pml4, void *upage) {
 	uint64_t *pte;
@@ -257,8 +509,7 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
 		*pte &= ~PTE_P;
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) upage);
+		tlb_flush_page (pml4, (uint64_t) upage);
 	}
 }
 
@@ -283,8 +534,7 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
 		else
 			*pte &= ~(uint32_t) PTE_D;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		tlb_flush_page (pml4, (uint64_t) vpage);
 	}
 }
 
@@ -309,7 +559,6 @@ pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
 		else
 			*pte &= ~(uint32_t) PTE_A;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		tlb_flush_page (pml4, (uint64_t) vpage);
 	}
 }
@@ -2,14 +2,20 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
+#ifdef MEMPROF
+#include "threads/memprof.h"
+#endif
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -24,15 +30,86 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
-
-/* A memory pool. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   NOTE: [Improve] Each pool is a binary buddy allocator.  Free
+   memory is kept as blocks of 2**ORDER pages aligned to their
+   size (relative to the pool base), one free list per order.
+   Allocation splits the smallest large-enough block and freeing
+   merges a block with its free buddy, both in O(log n).  The
+   free lists are threaded through the free pages themselves and
+   ORDER_MAP records, for the first page of every free block, its
+   order.  USED_MAP still tracks every allocated page so that
+   page_from_pool() and double-free checks keep working. */
+
+#define BUDDY_ORDERS 21                 /* Blocks of up to 2**20 pages. */
+#define BUDDY_FREE 0x80                 /* ORDER_MAP: page heads a free block. */
+
+/* A memory pool.  Only touched with interrupts off, so that it
+   can also be used from interrupt handlers. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	uint8_t *order_map;             /* Per page: BUDDY_FREE | order, or 0. */
+	struct list free_list[BUDDY_ORDERS]; /* Free blocks of each order. */
+	size_t free_cnt[BUDDY_ORDERS];  /* # of blocks in each free_list. */
+
+	/* Magazine statistics. */
+	long long mag_hits;             /* Single pages served by a magazine. */
+	long long mag_refills;          /* Batches moved from pool to magazine. */
+	long long mag_drains;           /* Batches moved from magazine to pool. */
+
+	/* Pre-zeroed pages. */
+	struct list clean_list;         /* Zeroed single pages. */
+	size_t clean_cnt;               /* # of pages in clean_list. */
+	long long zero_hits;            /* PAL_ZERO pages taken from clean_list. */
+	long long zero_misses;          /* PAL_ZERO pages zeroed inline. */
+};
+
+/* NOTE: [Improve] Pre-zeroed pages.  The idle thread keeps up to
+   CLEAN_TARGET zeroed pages per pool on a clean list, so
+   single-page PAL_ZERO requests usually skip the memset.  Zeroing
+   only happens when no thread is ready to run, so it takes no
+   share of the CPU from any scheduler and never counts toward
+   load_avg.  Clean pages count as used in the pool; when the pool
+   runs dry they are given back before failing a request.  The
+   list element lives in the first bytes of each clean page and is
+   cleared when the page is handed out. */
+#define CLEAN_TARGET 64                 /* Clean pages kept per pool. */
+
+/* NOTE: [Improve] Shrinkers.  Allocators that cache free pages of
+   their own (malloc()'s empty arenas) register a callback here.
+   When the kernel pool cannot satisfy a request, the callbacks are
+   run and the request is retried once.  Only done when the caller
+   has interrupts on, so that no pool is in the middle of an update. */
+#define SHRINKER_MAX 4
+
+static palloc_shrinker_func *shrinkers[SHRINKER_MAX];
+static int shrinker_cnt;
+
+/* NOTE: [Improve] Page magazines.  Single-page requests, which
+   dominate (page faults, thread stacks), are served from a small
+   stack of free pages in front of each pool without walking the
+   buddy free lists.  An empty magazine is refilled with
+   palloc_mag_batch pages in one pass, and a magazine that reaches
+   palloc_mag_high pages gives its oldest palloc_mag_batch pages
+   back to the pool.  Pages in a magazine still count as used in
+   the pool's used_map.  A magazine is only touched with
+   interrupts off. */
+#define MAG_MAX 64                      /* Capacity of a magazine. */
+
+struct magazine {
+	size_t cnt;                     /* # of pages in PAGES. */
+	void *pages[MAG_MAX];           /* Free pages, most recently freed last. */
 };
 
+/* Magazines: index 0 for the kernel pool, 1 for user. */
+static struct magazine magazines[2];
+
+/* Magazine watermarks, set with "-pmag=HIGH[,BATCH]". */
+size_t palloc_mag_high = 32;
+size_t palloc_mag_batch = 16;
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
@@ -42,6 +119,19 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void buddy_init (struct pool *);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void *get_pages (enum palloc_flags, size_t page_cnt);
+static void free_pages (void *pages, size_t page_cnt);
+static void *pool_alloc (struct pool *, size_t page_cnt);
+static struct magazine *pool_magazine (struct pool *);
+static void mag_refill (struct pool *, struct magazine *);
+static void mag_drain (struct pool *, struct magazine *, size_t cnt);
+static void *clean_take (struct pool *);
+static void clean_drain (struct pool *);
+static size_t run_shrinkers (void);
+static bool clean_fill_one (struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -250,6 +340,8 @@ palloc_init (void) {
 	printf ("\text_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n",
 		  ext_mem.start, ext_mem.end, ext_mem.size / 1024);
 	populate_pools (&base_mem, &ext_mem);
+	buddy_init (&kernel_pool);
+	buddy_init (&user_pool);
 	return ext_mem.end;
 }
 
@@ -261,17 +353,64 @@ palloc_init (void) {
    FLAGS, in which case the kernel panics. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
-	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	void *pages = get_pages (flags, page_cnt);
+#ifdef MEMPROF
+	memprof_alloc (MEMPROF_PALLOC, pages, page_cnt * PGSIZE,
+			__builtin_return_address (0));
+#endif
+	return pages;
+}
 
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
+/* Does the work of palloc_get_multiple(). */
+static void *
+get_pages (enum palloc_flags flags, size_t page_cnt) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	enum intr_level old_level;
+	struct magazine *mag;
 	void *pages;
 
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
+	/* NOTE: [Improve] Single zeroed pages come from the clean list. */
+	if ((flags & PAL_ZERO) && page_cnt == 1) {
+		pages = clean_take (pool);
+		if (pages != NULL)
+			return pages;
+	}
+
+	old_level = intr_disable ();
+	mag = pool_magazine (pool);
+	if (page_cnt == 1 && palloc_mag_high > 0) {
+		if (mag->cnt > 0)
+			pool->mag_hits++;
+		else
+			mag_refill (pool, mag);
+		pages = mag->cnt > 0 ? mag->pages[--mag->cnt] : NULL;
+	} else {
+		pages = pool_alloc (pool, page_cnt);
+
+		/* Pages parked in the magazine may be what keeps the pool
+		   from having a large enough block. */
+		if (pages == NULL && mag->cnt > 0) {
+			mag_drain (pool, mag, mag->cnt);
+			pages = pool_alloc (pool, page_cnt);
+		}
+	}
+
+	/* Last resort: give the pre-zeroed pages back. */
+	if (pages == NULL && pool->clean_cnt > 0) {
+		clean_drain (pool);
+		pages = pool_alloc (pool, page_cnt);
+	}
+	intr_set_level (old_level);
+
+	/* Ask other allocators for their cached pages. */
+	if (pages == NULL && pool == &kernel_pool && old_level == INTR_ON
+			&& !intr_context () && run_shrinkers () > 0) {
+		old_level = intr_disable ();
+		mag = pool_magazine (pool);
+		mag_drain (pool, mag, mag->cnt);
+		pages = pool_alloc (pool, page_cnt);
+		intr_set_level (old_level);
+	}
 
 	if (pages) {
 		if (flags & PAL_ZERO)
@@ -293,13 +432,59 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
    FLAGS, in which case the kernel panics. */
 void *
 palloc_get_page (enum palloc_flags flags) {
-	return palloc_get_multiple (flags, 1);
+	void *page = get_pages (flags, 1);
+#ifdef MEMPROF
+	memprof_alloc (MEMPROF_PALLOC, page, PGSIZE, __builtin_return_address (0));
+#endif
+	return page;
+}
+
+/* NOTE: [Improve] Like palloc_get_multiple(), but the physical
+   address of the first page is a multiple of ALIGN, a power of
+   two no smaller than PGSIZE.  Used for the backing of 2 MB
+   pages.  The pages are freed with palloc_free_multiple(). */
+void *
+palloc_get_aligned (enum palloc_flags flags, size_t page_cnt, size_t align) {
+	size_t extra = align / PGSIZE - 1;
+	uint8_t *pages, *aligned;
+	size_t head;
+
+	ASSERT (align >= PGSIZE && (align & (align - 1)) == 0);
+
+	/* Take enough to contain an aligned run, then trim both ends. */
+	pages = get_pages (flags & ~PAL_ZERO, page_cnt + extra);
+	if (pages == NULL)
+		return NULL;
+	aligned = ptov ((vtop (pages) + align - 1) & ~(uint64_t) (align - 1));
+	head = (aligned - pages) / PGSIZE;
+	free_pages (pages, head);
+	free_pages (aligned + page_cnt * PGSIZE, extra - head);
+
+	if (flags & PAL_ZERO)
+		memset (aligned, 0, PGSIZE * page_cnt);
+#ifdef MEMPROF
+	memprof_alloc (MEMPROF_PALLOC, aligned, page_cnt * PGSIZE,
+			__builtin_return_address (0));
+#endif
+	return aligned;
 }
 
 /* Frees the PAGE_CNT pages starting at PAGES. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) {
+	if (pages == NULL || page_cnt == 0)
+		return;
+#ifdef MEMPROF
+	memprof_free (MEMPROF_PALLOC, pages);
+#endif
+	free_pages (pages, page_cnt);
+}
+
+/* Does the work of palloc_free_multiple(). */
+static void
+free_pages (void *pages, size_t page_cnt) {
 	struct pool *pool;
+	enum intr_level old_level;
 	size_t page_idx;
 
 	ASSERT (pg_ofs (pages) == 0);
@@ -318,8 +503,47 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
+	old_level = intr_disable ();
+	if (page_cnt == 1 && palloc_mag_high > 0) {
+		struct magazine *mag = pool_magazine (pool);
+
+#ifndef NDEBUG
+		/* Catch double frees: the page must still be allocated
+		   and must not be parked in the magazine already. */
+		ASSERT (bitmap_test (pool->used_map, page_idx));
+		for (size_t i = 0; i < mag->cnt; i++)
+			ASSERT (mag->pages[i] != pages);
+#endif
+		if (mag->cnt >= palloc_mag_high)
+			mag_drain (pool, mag, palloc_mag_batch);
+		mag->pages[mag->cnt++] = pages;
+		intr_set_level (old_level);
+		return;
+	}
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
 	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	buddy_free (pool, page_idx, page_cnt);
+	intr_set_level (old_level);
+}
+
+/* Registers SHRINKER to be called when the kernel pool runs out
+   of pages. */
+void
+palloc_register_shrinker (palloc_shrinker_func *shrinker) {
+	ASSERT (shrinker_cnt < SHRINKER_MAX);
+	shrinkers[shrinker_cnt++] = shrinker;
+}
+
+/* Runs every registered shrinker and returns the total number of
+   pages they gave back. */
+static size_t
+run_shrinkers (void) {
+	size_t released = 0;
+	int i;
+
+	for (i = 0; i < shrinker_cnt; i++)
+		released += shrinkers[i] ();
+	return released;
 }
 
 /* Frees the page at PAGE. */
@@ -336,8 +560,8 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
      and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t om_pages = DIV_ROUND_UP (pgcnt, PGSIZE) * PGSIZE;
 
-	lock_init(&p->lock);
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
 	p->base = (void *) start;
 
@@ -345,6 +569,11 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
 	bitmap_set_all(p->used_map, true);
 
 	*bm_base += bm_pages;
+
+	/* NOTE: [Improve] The buddy order map follows the bitmap. */
+	p->order_map = *bm_base;
+	memset (p->order_map, 0, pgcnt);
+	*bm_base += om_pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -356,3 +585,317 @@ page_from_pool (const struct pool *pool, void *page) {
 	size_t end_page = start_page + bitmap_size (pool->used_map);
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the free block of POOL that starts at page PAGE_IDX. */
+static struct list_elem *
+block_elem (struct pool *pool, size_t page_idx) {
+	return (struct list_elem *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Returns the page index of the free block whose list element is E. */
+static size_t
+block_idx (struct pool *pool, struct list_elem *e) {
+	return ((uint8_t *) e - pool->base) / PGSIZE;
+}
+
+/* Returns the smallest order whose block holds PAGE_CNT pages. */
+static int
+order_of (size_t page_cnt) {
+	int order = 0;
+
+	while (((size_t) 1 << order) < page_cnt)
+		order++;
+	return order;
+}
+
+/* Puts the 2**ORDER pages at PAGE_IDX on POOL's free lists,
+   merging with the buddy block as long as it is free too. */
+static void
+buddy_free_block (struct pool *pool, size_t page_idx, int order) {
+	size_t pool_pages = bitmap_size (pool->used_map);
+
+	while (order < BUDDY_ORDERS - 1) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy + ((size_t) 1 << order) > pool_pages
+				|| pool->order_map[buddy] != (BUDDY_FREE | order))
+			break;
+		list_remove (block_elem (pool, buddy));
+		pool->free_cnt[order]--;
+		pool->order_map[buddy] = 0;
+		if (buddy < page_idx)
+			page_idx = buddy;
+		order++;
+	}
+
+	pool->order_map[page_idx] = BUDDY_FREE | order;
+	list_push_front (&pool->free_list[order], block_elem (pool, page_idx));
+	pool->free_cnt[order]++;
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX, which need not be a
+   power of two, as the largest aligned blocks that fit. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = 0;
+
+		while (order < BUDDY_ORDERS - 1
+				&& (page_idx & ((size_t) 1 << order)) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		buddy_free_block (pool, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first one, or BITMAP_ERROR if there is no free
+   block big enough.  A request that is not a power of two takes
+   the next larger block and gives the unused tail back. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt) {
+	int want = order_of (page_cnt);
+	int order;
+	size_t page_idx;
+
+	if (page_cnt == 0 || want >= BUDDY_ORDERS)
+		return BITMAP_ERROR;
+	for (order = want; order < BUDDY_ORDERS; order++)
+		if (!list_empty (&pool->free_list[order]))
+			break;
+	if (order == BUDDY_ORDERS)
+		return BITMAP_ERROR;
+
+	page_idx = block_idx (pool, list_pop_front (&pool->free_list[order]));
+	pool->free_cnt[order]--;
+	pool->order_map[page_idx] = 0;
+
+	/* Split down to the wanted order, freeing the upper halves. */
+	while (order > want) {
+		size_t half;
+
+		order--;
+		half = page_idx + ((size_t) 1 << order);
+		pool->order_map[half] = BUDDY_FREE | order;
+		list_push_front (&pool->free_list[order], block_elem (pool, half));
+		pool->free_cnt[order]++;
+	}
+
+	if (page_cnt < ((size_t) 1 << want))
+		buddy_free (pool, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+	return page_idx;
+}
+
+/* Builds POOL's free lists from the pages that populate_pools()
+   marked free in its used_map. */
+static void
+buddy_init (struct pool *pool) {
+	size_t pool_pages = bitmap_size (pool->used_map);
+	size_t start = 0;
+	int order;
+
+	for (order = 0; order < BUDDY_ORDERS; order++) {
+		list_init (&pool->free_list[order]);
+		pool->free_cnt[order] = 0;
+	}
+	list_init (&pool->clean_list);
+	pool->clean_cnt = 0;
+
+	while (start < pool_pages) {
+		size_t end;
+
+		start = bitmap_scan (pool->used_map, start, 1, false);
+		if (start == BITMAP_ERROR)
+			break;
+		end = bitmap_scan (pool->used_map, start, 1, true);
+		if (end == BITMAP_ERROR)
+			end = pool_pages;
+		buddy_free (pool, start, end - start);
+		start = end;
+	}
+}
+
+/* Allocates PAGE_CNT contiguous pages directly from POOL.
+   Must be called with interrupts off. */
+static void *
+pool_alloc (struct pool *pool, size_t page_cnt) {
+	size_t page_idx;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	page_idx = buddy_alloc (pool, page_cnt);
+	if (page_idx != BITMAP_ERROR)
+		bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+
+	return page_idx != BITMAP_ERROR ? pool->base + PGSIZE * page_idx : NULL;
+}
+
+/* Returns the magazine for POOL.
+   Must be called with interrupts off. */
+static struct magazine *
+pool_magazine (struct pool *pool) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	return &magazines[pool == &user_pool];
+}
+
+/* Moves up to palloc_mag_batch single pages from POOL into MAG.
+   Must be called with interrupts off. */
+static void
+mag_refill (struct pool *pool, struct magazine *mag) {
+	size_t want = palloc_mag_batch;
+
+	if (want > MAG_MAX - mag->cnt)
+		want = MAG_MAX - mag->cnt;
+
+	while (want-- > 0) {
+		size_t page_idx = buddy_alloc (pool, 1);
+
+		if (page_idx == BITMAP_ERROR)
+			break;
+		bitmap_mark (pool->used_map, page_idx);
+		mag->pages[mag->cnt++] = pool->base + PGSIZE * page_idx;
+	}
+	pool->mag_refills++;
+}
+
+/* Gives the CNT least recently freed pages of MAG back to POOL.
+   Must be called with interrupts off. */
+static void
+mag_drain (struct pool *pool, struct magazine *mag, size_t cnt) {
+	size_t i;
+
+	if (cnt > mag->cnt)
+		cnt = mag->cnt;
+
+	for (i = 0; i < cnt; i++) {
+		size_t page_idx = pg_no (mag->pages[i]) - pg_no (pool->base);
+
+		bitmap_reset (pool->used_map, page_idx);
+		buddy_free (pool, page_idx, 1);
+	}
+	pool->mag_drains++;
+
+	mag->cnt -= cnt;
+	memmove (mag->pages, mag->pages + cnt, mag->cnt * sizeof *mag->pages);
+}
+
+/* Takes a zeroed page from POOL's clean list and returns it, or
+   returns a null pointer and counts a miss if the list is empty.
+   The idle thread refills the list. */
+static void *
+clean_take (struct pool *pool) {
+	enum intr_level old_level;
+	struct list_elem *e = NULL;
+
+	old_level = intr_disable ();
+	if (!list_empty (&pool->clean_list)) {
+		e = list_pop_front (&pool->clean_list);
+		pool->clean_cnt--;
+		pool->zero_hits++;
+	} else
+		pool->zero_misses++;
+	intr_set_level (old_level);
+
+	if (e != NULL)
+		memset (e, 0, sizeof *e);
+	return e;
+}
+
+/* Returns every page on POOL's clean list to the buddy
+   allocator.  Must be called with interrupts off. */
+static void
+clean_drain (struct pool *pool) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (!list_empty (&pool->clean_list)) {
+		void *page = list_pop_front (&pool->clean_list);
+		size_t page_idx = pg_no (page) - pg_no (pool->base);
+
+		bitmap_reset (pool->used_map, page_idx);
+		buddy_free (pool, page_idx, 1);
+	}
+	pool->clean_cnt = 0;
+}
+
+/* Adds one zeroed page to POOL's clean list.  Returns false if
+   the list is already full or POOL has no free page.  The page is
+   zeroed with interrupts on, so this never delays anything but
+   the calling thread. */
+static bool
+clean_fill_one (struct pool *pool) {
+	enum intr_level old_level;
+	void *page;
+
+	if (pool->clean_cnt >= CLEAN_TARGET)
+		return false;
+
+	old_level = intr_disable ();
+	page = pool_alloc (pool, 1);
+	intr_set_level (old_level);
+	if (page == NULL)
+		return false;
+
+	memset (page, 0, PGSIZE);
+
+	old_level = intr_disable ();
+	list_push_back (&pool->clean_list, page);
+	pool->clean_cnt++;
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Zeroes one page for a clean list that is short of
+   CLEAN_TARGET and returns true, or returns false if there is
+   nothing to do.  Called by the idle thread with interrupts on,
+   one page at a time so that it can stop as soon as another
+   thread becomes ready.  Never sleeps. */
+bool
+palloc_zero_idle (void) {
+	ASSERT (intr_get_level () == INTR_ON);
+
+	return clean_fill_one (&kernel_pool) || clean_fill_one (&user_pool);
+}
+
+/* Sets the magazine watermarks: a magazine holding HIGH pages
+   gives BATCH of them back to the pool, and an empty one takes
+   BATCH pages.  HIGH of 0 disables the magazines.  Returns false
+   if the values are out of range.  Only meant to be called at
+   boot, before any page is allocated. */
+bool
+palloc_set_magazine (size_t high, size_t batch) {
+	if (high > MAG_MAX || (high > 0 && (batch == 0 || batch > high)))
+		return false;
+	palloc_mag_high = high;
+	palloc_mag_batch = batch;
+	return true;
+}
+
+/* Prints the number of free blocks of each order in one pool. */
+static void
+print_pool_stats (const char *name, struct pool *pool) {
+	size_t free_pages = 0, mag_pages = 0;
+	int order;
+
+	printf ("Palloc: %s pool free blocks by order:", name);
+	for (order = 0; order < BUDDY_ORDERS; order++) {
+		if (pool->free_cnt[order] > 0)
+			printf (" %d:%zu", order, pool->free_cnt[order]);
+		free_pages += pool->free_cnt[order] << order;
+	}
+	mag_pages = magazines[pool == &user_pool].cnt;
+	printf (" (%zu pages free, %zu in magazines)\n", free_pages, mag_pages);
+	printf ("Palloc: %s pool magazines: %lld hits, %lld refills, %lld drains\n",
+			name, pool->mag_hits, pool->mag_refills, pool->mag_drains);
+	printf ("Palloc: %s pool zeroed pages: %lld hits, %lld misses, %zu clean\n",
+			name, pool->zero_hits, pool->zero_misses, pool->clean_cnt);
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) {
+	print_pool_stats ("kernel", &kernel_pool);
+	print_pool_stats ("user", &user_pool);
+}
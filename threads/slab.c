@@ -0,0 +1,454 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Slab allocator.
+
+   Every cache owns a set of slabs.  A slab is one page obtained
+   from the page allocator: a struct slab header, an array of free
+   object indices, and then as many objects of the cache's exact
+   size as fit.  Freeing an object finds its slab by rounding the
+   address down to the page boundary, like malloc() finds its
+   arena.
+
+   Slabs are kept on one of three lists: full (no free objects),
+   partial, and empty (every object free).  Allocation prefers
+   partial slabs so that empty ones can be given back.  At most
+   one empty slab is kept per cache; kmem_cache_shrink() releases
+   that one too.
+
+   Because the free list is an index array in the header rather
+   than a link stored in the object, a free object keeps whatever
+   its constructor or its last user left in it.
+
+   In front of the slabs, each cache has a small magazine of free
+   objects.  Allocation and free touch only the magazine until it
+   runs empty or full; then KMEM_MAG_BATCH objects are moved to or
+   from the slabs at once.  A cache is only touched with interrupts
+   off.  Objects in a magazine are still counted as in use by
+   their slab. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab0b1e
+
+#define KMEM_NAME_MAX 15                /* Longest cache name. */
+#define KMEM_MAG_MAX 16                 /* Capacity of a magazine. */
+#define KMEM_MAG_BATCH 8                /* Objects moved per refill/drain. */
+
+/* Slab header, at the start of each slab page. */
+struct slab {
+	unsigned magic;                 /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;       /* Owning cache. */
+	struct list_elem elem;          /* Element in a cache's slab list. */
+	uint8_t *objs;                  /* First object. */
+	size_t free_cnt;                /* # of entries in FREE_IDX. */
+	uint16_t free_idx[];            /* Indices of free objects. */
+};
+
+/* Stack of free objects in front of a cache's slabs. */
+struct kmem_magazine {
+	size_t cnt;                     /* # of objects in OBJS. */
+	void *objs[KMEM_MAG_MAX];       /* Free objects, most recently freed last. */
+};
+
+/* Object cache. */
+struct kmem_cache {
+	char name[KMEM_NAME_MAX + 1];   /* Name, for statistics. */
+	size_t size;                    /* Requested object size. */
+	size_t obj_size;                /* SIZE rounded up to the alignment. */
+	size_t obj_cnt;                 /* Objects per slab. */
+	size_t obj_ofs;                 /* Offset of the first object in a slab. */
+	kmem_ctor_func *ctor;           /* Constructor, or a null pointer. */
+	struct list_elem elem;          /* Element in cache_list. */
+
+	struct list full;               /* Slabs with no free object. */
+	struct list partial;            /* Slabs with some free objects. */
+	struct list empty;              /* Slabs with only free objects. */
+	size_t slab_cnt;                /* # of slabs on all three lists. */
+	size_t empty_cnt;               /* # of slabs on EMPTY. */
+	size_t inuse;                   /* Objects taken out of slabs. */
+
+	struct kmem_magazine mag;       /* Recently freed objects. */
+
+	/* Statistics. */
+	long long allocs;               /* Calls to kmem_cache_alloc(). */
+	long long mag_hits;             /* Allocations served by a magazine. */
+	long long grows;                /* Slabs allocated. */
+	long long reaps;                /* Slabs given back. */
+};
+
+/* The cache that struct kmem_cache objects come from. */
+static struct kmem_cache cache_cache;
+
+/* All caches, in creation order. */
+static struct list cache_list;
+static struct lock cache_list_lock;
+
+static void cache_setup (struct kmem_cache *, const char *name,
+		size_t size, size_t align, kmem_ctor_func *);
+static struct slab *obj_to_slab (void *);
+static bool slab_grow (struct kmem_cache *);
+static void slab_relist (struct kmem_cache *, struct slab *);
+static void slab_release (struct kmem_cache *, struct slab *);
+static void *slab_take (struct kmem_cache *);
+static void slab_put (struct kmem_cache *, void *);
+static void mag_refill (struct kmem_cache *, struct kmem_magazine *);
+static void mag_drain (struct kmem_cache *, struct kmem_magazine *,
+		size_t cnt);
+
+/* Initializes the slab allocator.  Must be called after
+   palloc_init(). */
+void
+slab_init (void) {
+	list_init (&cache_list);
+	lock_init (&cache_list_lock);
+	cache_setup (&cache_cache, "kmem_cache", sizeof (struct kmem_cache),
+			0, NULL);
+	list_push_back (&cache_list, &cache_cache.elem);
+}
+
+/* Creates and returns a cache of SIZE-byte objects aligned to
+   ALIGN bytes, which must be a power of 2, or 0 for pointer
+   alignment.  CTOR, if non-null, constructs each object when its
+   slab is allocated; it runs with interrupts off and must not
+   sleep.  NAME is only used for statistics.  Returns a null
+   pointer if memory is not available. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, size_t align,
+		kmem_ctor_func *ctor) {
+	struct kmem_cache *c = kmem_cache_alloc (&cache_cache);
+	if (c == NULL)
+		return NULL;
+
+	cache_setup (c, name, size, align, ctor);
+	lock_acquire (&cache_list_lock);
+	list_push_back (&cache_list, &c->elem);
+	lock_release (&cache_list_lock);
+	return c;
+}
+
+/* Destroys cache C.  Every object allocated from C must have
+   been freed. */
+void
+kmem_cache_destroy (struct kmem_cache *c) {
+	ASSERT (c != NULL && c != &cache_cache);
+
+	kmem_cache_shrink (c);
+	ASSERT (c->slab_cnt == 0);
+
+	lock_acquire (&cache_list_lock);
+	list_remove (&c->elem);
+	lock_release (&cache_list_lock);
+	kmem_cache_free (&cache_cache, c);
+}
+
+/* Obtains and returns an object from cache C.
+   Returns a null pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct kmem_magazine *mag;
+	enum intr_level old_level;
+	void *obj = NULL;
+
+	ASSERT (c != NULL);
+
+	old_level = intr_disable ();
+	c->allocs++;
+	mag = &c->mag;
+	if (mag->cnt > 0)
+		c->mag_hits++;
+	else
+		mag_refill (c, mag);
+	if (mag->cnt > 0)
+		obj = mag->objs[--mag->cnt];
+	intr_set_level (old_level);
+
+	return obj;
+}
+
+/* Like kmem_cache_alloc(), but clears the object.  Only for
+   caches without a constructor. */
+void *
+kmem_cache_zalloc (struct kmem_cache *c) {
+	void *obj;
+
+	ASSERT (c->ctor == NULL);
+
+	obj = kmem_cache_alloc (c);
+	if (obj != NULL)
+		memset (obj, 0, c->size);
+	return obj;
+}
+
+/* Returns OBJ, which must have been allocated from cache C, to
+   C.  OBJ may be a null pointer, in which case nothing happens. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct kmem_magazine *mag;
+	enum intr_level old_level;
+
+	if (obj == NULL)
+		return;
+	ASSERT (obj_to_slab (obj)->cache == c);
+
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs.
+	   Constructed objects must keep their state. */
+	if (c->ctor == NULL)
+		memset (obj, 0xcc, c->obj_size);
+#endif
+
+	old_level = intr_disable ();
+	mag = &c->mag;
+	if (mag->cnt >= KMEM_MAG_MAX)
+		mag_drain (c, mag, KMEM_MAG_BATCH);
+	mag->objs[mag->cnt++] = obj;
+	intr_set_level (old_level);
+}
+
+/* Gives back to the page allocator every empty slab of cache C,
+   after emptying its magazine into the slabs.
+   Returns the number of pages released. */
+size_t
+kmem_cache_shrink (struct kmem_cache *c) {
+	enum intr_level old_level;
+	size_t released = 0;
+
+	old_level = intr_disable ();
+	mag_drain (c, &c->mag, c->mag.cnt);
+	while (!list_empty (&c->empty)) {
+		slab_release (c, list_entry (list_front (&c->empty),
+					struct slab, elem));
+		released++;
+	}
+	intr_set_level (old_level);
+
+	return released;
+}
+
+/* Returns the number of objects in each slab of cache C. */
+size_t
+kmem_cache_objs_per_slab (const struct kmem_cache *c) {
+	return c->obj_cnt;
+}
+
+/* Returns the number of slabs that cache C currently holds. */
+size_t
+kmem_cache_slabs (const struct kmem_cache *c) {
+	return c->slab_cnt;
+}
+
+/* Initializes cache C.  See kmem_cache_create(). */
+static void
+cache_setup (struct kmem_cache *c, const char *name, size_t size,
+		size_t align, kmem_ctor_func *ctor) {
+	size_t cnt;
+
+	if (align == 0)
+		align = sizeof (void *);
+	ASSERT (size > 0);
+	ASSERT ((align & (align - 1)) == 0);
+
+	memset (c, 0, sizeof *c);
+	strlcpy (c->name, name, sizeof c->name);
+	c->size = size;
+	c->obj_size = ROUND_UP (size, align);
+	c->ctor = ctor;
+
+	/* Fit as many objects as possible behind the header and its
+	   index array. */
+	cnt = (PGSIZE - sizeof (struct slab))
+		/ (c->obj_size + sizeof (uint16_t));
+	while (cnt > 0
+			&& ROUND_UP (sizeof (struct slab) + cnt * sizeof (uint16_t), align)
+			+ cnt * c->obj_size > PGSIZE)
+		cnt--;
+	ASSERT (cnt > 0);
+	c->obj_cnt = cnt;
+	c->obj_ofs = ROUND_UP (sizeof (struct slab) + cnt * sizeof (uint16_t),
+			align);
+
+	list_init (&c->full);
+	list_init (&c->partial);
+	list_init (&c->empty);
+}
+
+/* Returns the slab that OBJ is inside. */
+static struct slab *
+obj_to_slab (void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	/* Check that the slab is valid and OBJ is one of its objects. */
+	ASSERT (s != NULL);
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT ((uint8_t *) obj >= s->objs);
+	ASSERT (((uint8_t *) obj - s->objs) % s->cache->obj_size == 0);
+
+	return s;
+}
+
+/* Adds a new, empty slab to cache C.  Returns false if memory is
+   not available.  Must be called with interrupts off. */
+static bool
+slab_grow (struct kmem_cache *c) {
+	struct slab *s;
+	size_t i;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	s = palloc_get_page (0);
+	if (s == NULL)
+		return false;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->objs = (uint8_t *) s + c->obj_ofs;
+	s->free_cnt = c->obj_cnt;
+	for (i = 0; i < c->obj_cnt; i++) {
+		/* Hand out objects in address order. */
+		s->free_idx[i] = c->obj_cnt - 1 - i;
+		if (c->ctor != NULL)
+			c->ctor (s->objs + i * c->obj_size);
+	}
+
+	list_push_back (&c->empty, &s->elem);
+	c->empty_cnt++;
+	c->slab_cnt++;
+	c->grows++;
+	return true;
+}
+
+/* Moves slab S to the list that matches its free count.
+   Must be called with interrupts off. */
+static void
+slab_relist (struct kmem_cache *c, struct slab *s) {
+	struct list *list;
+
+	list_remove (&s->elem);
+	if (s->free_cnt == 0)
+		list = &c->full;
+	else if (s->free_cnt < c->obj_cnt)
+		list = &c->partial;
+	else
+		list = &c->empty;
+	list_push_front (list, &s->elem);
+}
+
+/* Gives empty slab S of cache C back to the page allocator.
+   Must be called with interrupts off. */
+static void
+slab_release (struct kmem_cache *c, struct slab *s) {
+	ASSERT (s->free_cnt == c->obj_cnt);
+
+	list_remove (&s->elem);
+	c->empty_cnt--;
+	c->slab_cnt--;
+	c->reaps++;
+	s->magic = 0;
+	palloc_free_page (s);
+}
+
+/* Takes a free object out of cache C's slabs, growing C if
+   needed.  Returns a null pointer if memory is not available.
+   Must be called with interrupts off. */
+static void *
+slab_take (struct kmem_cache *c) {
+	struct slab *s;
+
+	if (!list_empty (&c->partial))
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	else if (!list_empty (&c->empty) || slab_grow (c)) {
+		s = list_entry (list_front (&c->empty), struct slab, elem);
+		c->empty_cnt--;
+	} else
+		return NULL;
+
+	ASSERT (s->free_cnt > 0);
+	s->free_cnt--;
+	if (s->free_cnt == 0 || s->free_cnt == c->obj_cnt - 1)
+		slab_relist (c, s);
+	c->inuse++;
+	return s->objs + s->free_idx[s->free_cnt] * c->obj_size;
+}
+
+/* Returns OBJ to its slab in cache C.  Keeps at most one empty
+   slab around.  Must be called with interrupts off. */
+static void
+slab_put (struct kmem_cache *c, void *obj) {
+	struct slab *s = obj_to_slab (obj);
+
+	ASSERT (s->free_cnt < c->obj_cnt);
+	s->free_idx[s->free_cnt++] = ((uint8_t *) obj - s->objs) / c->obj_size;
+	c->inuse--;
+	if (s->free_cnt == 1 || s->free_cnt == c->obj_cnt)
+		slab_relist (c, s);
+	if (s->free_cnt == c->obj_cnt && ++c->empty_cnt > 1)
+		slab_release (c, s);
+}
+
+/* Fills empty magazine MAG with up to KMEM_MAG_BATCH objects from
+   cache C's slabs.  Must be called with interrupts off. */
+static void
+mag_refill (struct kmem_cache *c, struct kmem_magazine *mag) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (mag->cnt == 0);
+
+	while (mag->cnt < KMEM_MAG_BATCH) {
+		void *obj = slab_take (c);
+		if (obj == NULL)
+			break;
+		mag->objs[mag->cnt++] = obj;
+	}
+}
+
+/* Returns the CNT oldest objects of magazine MAG to cache C's
+   slabs.  Must be called with interrupts off. */
+static void
+mag_drain (struct kmem_cache *c, struct kmem_magazine *mag, size_t cnt) {
+	size_t i;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (cnt <= mag->cnt);
+
+	for (i = 0; i < cnt; i++)
+		slab_put (c, mag->objs[i]);
+	memmove (mag->objs, mag->objs + cnt, (mag->cnt - cnt) * sizeof *mag->objs);
+	mag->cnt -= cnt;
+}
+
+/* Prints slab allocator statistics: for each cache, how many of
+   its slots hold live objects and how much of its slab memory
+   does not. */
+void
+slab_print_stats (void) {
+	struct list_elem *e;
+
+	lock_acquire (&cache_list_lock);
+	for (e = list_begin (&cache_list); e != list_end (&cache_list);
+			e = list_next (e)) {
+		struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+		size_t active = c->inuse, bytes = c->slab_cnt * PGSIZE;
+		size_t waste_pct = 0;
+
+		active -= c->mag.cnt;
+		if (bytes > 0)
+			waste_pct = (bytes - active * c->size) * 100 / bytes;
+
+		printf ("Slab: %-15s %4zu bytes x %3zu: %zu/%zu objects active, "
+				"%zu slabs, %zu%% fragmented\n",
+				c->name, c->size, c->obj_cnt, active,
+				c->slab_cnt * c->obj_cnt, c->slab_cnt, waste_pct);
+		printf ("Slab: %-15s %lld allocs, %lld magazine hits, "
+				"%lld grows, %lld reaps\n",
+				c->name, c->allocs, c->mag_hits, c->grows, c->reaps);
+	}
+	lock_release (&cache_list_lock);
+}
@@ -32,7 +32,15 @@
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
-static bool cmp_priority_donation(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
+static void lock_take(struct lock *lock);
+static void transfer_tickets(struct thread *t, int tickets);
+static bool wait_less(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED);
+static void wait_heap_push(struct heap *waiters);
+static void wait_heap_requeue(struct heap *waiters);
+static struct thread *wait_heap_pop(struct heap *waiters);
+
+/* NOTE: [Improve] 같은 우선순위의 waiter들이 도착한 순서대로 깨어나도록 매기는 번호 */
+static uint64_t next_wait_seq;
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -47,7 +55,7 @@ void sema_init(struct semaphore *sema, unsigned value)
 {
 	ASSERT(sema != NULL);
 	sema->value = value;
-	list_init(&sema->waiters);
+	heap_init(&sema->waiters, wait_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -66,11 +74,17 @@ void sema_down(struct semaphore *sema)
 	ASSERT(!intr_context());
 
 	old_level = intr_disable();
-	while (sema->value == 0)
+	if (sema->value == 0)
 	{
-		// list_push_back(&sema->waiters, &thread_current()->elem);
-		list_insert_ordered(&sema->waiters, &thread_current()->elem, compare_priority, 0);
+		wait_heap_push(&sema->waiters);
 		thread_block();
+
+		/* 깨어났지만 다른 쓰레드가 먼저 가져갔다면 원래 순번으로 다시 기다린다. */
+		while (sema->value == 0)
+		{
+			wait_heap_requeue(&sema->waiters);
+			thread_block();
+		}
 	}
 	sema->value--;
 	intr_set_level(old_level);
@@ -112,12 +126,8 @@ void sema_up(struct semaphore *sema)
 	ASSERT(sema != NULL);
 
 	old_level = intr_disable();
-	if (!list_empty(&sema->waiters))
-	{
-		list_sort(&sema->waiters, compare_priority, 0);
-		thread_unblock(list_entry(list_pop_front(&sema->waiters),
-								  struct thread, elem));
-	}
+	if (!heap_empty(&sema->waiters))
+		thread_unblock(wait_heap_pop(&sema->waiters));
 	sema->value++;
 	thread_compare_yield();
 	intr_set_level(old_level);
@@ -179,6 +189,8 @@ void lock_init(struct lock *lock)
 	ASSERT(lock != NULL);
 
 	lock->holder = NULL;
+	lock->max_priority = PRI_MIN;
+	lock->donated_tickets = 0;
 	sema_init(&lock->semaphore, 1);
 }
 
@@ -192,51 +204,149 @@ void lock_init(struct lock *lock)
    we need to sleep. */
 void lock_acquire(struct lock *lock)
 {
+	enum intr_level old_level;
+	bool waited = false;
+
 	ASSERT(lock != NULL);
 	ASSERT(!intr_context());
 	ASSERT(!lock_held_by_current_thread(lock));
 
 	struct thread *curr = thread_current();
-	struct thread *lock_holder_t = lock->holder;
 
+	old_level = intr_disable();
 	if (lock->holder != NULL)
 	{
 		curr->wait_on_lock = lock;
-		list_insert_ordered(&lock_holder_t->donations, &curr->donation_elem, cmp_donation, 0);
-
-		// donate-nest passed
 		if (!thread_mlfqs)
 			donate_priority();
 
-		// donate-one passed
-		// if(lock_holder_t->priority < curr->priority){
-		// 	lock_holder_t->priority = curr->priority;
-		// }
+		/* NOTE: [Improve] stride 스케줄러에서는 티켓을 넘겨준다. */
+		transfer_tickets(curr, curr->tickets + curr->donated_tickets);
+		waited = true;
 	}
 
 	sema_down(&lock->semaphore);
+	if (waited)
+		lock->donated_tickets -= curr->tickets + curr->donated_tickets;
 	curr->wait_on_lock = NULL;
-	lock->holder = thread_current();
+	lock_take(lock);
+	intr_set_level(old_level);
+}
+
+/**
+ * @brief 현재 쓰레드의 우선순위를 wait_on_lock 체인을 따라 donation하는 함수
+ *
+ * NOTE: [Improve] 각 lock은 기다리는 쓰레드 중 가장 높은 우선순위(max_priority)를 가진다.
+ * 체인의 각 단계에서 lock의 max_priority와 holder의 우선순위만 올리면 되고,
+ * 더 이상 올릴 것이 없으면 바로 멈춘다. 인터럽트가 꺼진 상태에서 호출되어야 한다.
+ */
+static void donate_priority_from(struct thread *t);
+
+/* T의 우선순위를 RW를 읽기 모드로 잡고 있는 reader들에게 donation한다. */
+static void donate_to_readers(struct rwlock *rw, struct thread *t)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&rw->readers); e != list_end(&rw->readers); e = list_next(e))
+	{
+		struct thread *reader = list_entry(e, struct rw_hold, elem)->thread;
+
+		if (reader->priority >= t->priority)
+			continue;
+		thread_update_priority(reader, t->priority);
+		donate_priority_from(reader);
+	}
+}
+
+/* T가 기다리는 lock을 따라가며 T의 우선순위를 donation한다.
+   rwlock의 reader를 기다리는 writer라면 reader마다 갈라져 이어간다. */
+static void donate_priority_from(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	while (t->wait_on_lock != NULL)
+	{
+		struct lock *lock = t->wait_on_lock;
+		struct thread *holder = lock->holder;
+
+		if (lock->max_priority >= t->priority)
+			break;
+		lock->max_priority = t->priority;
+		if (holder == NULL)
+			break;
+
+		/* holder의 held_locks 정렬 유지 */
+		list_remove(&lock->elem);
+		list_insert_ordered(&holder->held_locks, &lock->elem, cmp_lock_priority, NULL);
+
+		if (holder->priority >= t->priority)
+			break;
+		thread_update_priority(holder, t->priority);
+		t = holder;
+	}
+
+	if (t->wait_on_rwlock != NULL)
+		donate_to_readers(t->wait_on_rwlock, t);
 }
 
 void donate_priority(void)
 {
-	int depth;
-	struct thread *cur = thread_current();
+	donate_priority_from(thread_current());
+}
+
+/**
+ * @brief T가 기다리는 lock의 체인을 따라 TICKETS만큼 티켓을 넘겨주는 함수
+ *
+ * 각 lock의 donated_tickets와 holder의 donated_tickets를 함께 바꾼다.
+ * 티켓이 바뀐 holder도 다른 lock을 기다리고 있다면 그 holder에게 이어서 넘겨준다.
+ * TICKETS가 음수이면 넘겨준 티켓을 되돌린다. 인터럽트가 꺼진 상태에서 호출되어야 한다.
+ */
+static void
+transfer_tickets(struct thread *t, int tickets)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
 
-	for (depth = 0; depth < 8; depth++)
+	/* 체인 전체를 따라가야 lock_acquire()와 lock_release()에서
+	   되돌리는 티켓과 정확히 맞는다. */
+	while (t->wait_on_lock != NULL)
 	{
-		if (!cur->wait_on_lock)
+		struct lock *lock = t->wait_on_lock;
+
+		lock->donated_tickets += tickets;
+		if (lock->holder == NULL)
 			break;
-		struct thread *holder = cur->wait_on_lock->holder;
-		holder->priority = cur->priority;
-		cur = holder;
+		lock->holder->donated_tickets += tickets;
+		t = lock->holder;
 	}
 }
 
-bool cmp_donation(struct list_elem *a, struct list_elem *b, void *aux UNUSED)
+/* Returns true if lock A has a higher max_priority than lock B,
+   false otherwise. */
+bool cmp_lock_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
+{
+	return list_entry(a, struct lock, elem)->max_priority > list_entry(b, struct lock, elem)->max_priority;
+}
+
+/* Makes the current thread the holder of LOCK, whose semaphore
+   it has just downed, and takes over donations from the threads
+   still waiting for LOCK.  Interrupts must be off. */
+static void
+lock_take(struct lock *lock)
 {
-	return list_entry(a, struct thread, donation_elem)->priority > list_entry(b, struct thread, donation_elem)->priority;
+	struct thread *curr = thread_current();
+	struct heap *waiters = &lock->semaphore.waiters;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	lock->holder = curr;
+	lock->max_priority = PRI_MIN;
+	if (!heap_empty(waiters))
+		lock->max_priority = heap_entry(heap_min(waiters), struct thread, wait_elem)->priority;
+	list_insert_ordered(&curr->held_locks, &lock->elem, cmp_lock_priority, NULL);
+	curr->donated_tickets += lock->donated_tickets;
+
+	if (!thread_mlfqs)
+		update_donate_priority();
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -247,14 +357,17 @@ bool cmp_donation(struct list_elem *a, struct list_elem *b, void *aux UNUSED)
    interrupt handler. */
 bool lock_try_acquire(struct lock *lock)
 {
+	enum intr_level old_level;
 	bool success;
 
 	ASSERT(lock != NULL);
 	ASSERT(!lock_held_by_current_thread(lock));
 
+	old_level = intr_disable();
 	success = sema_try_down(&lock->semaphore);
 	if (success)
-		lock->holder = thread_current();
+		lock_take(lock);
+	intr_set_level(old_level);
 	return success;
 }
 
@@ -266,75 +379,352 @@ bool lock_try_acquire(struct lock *lock)
    handler. */
 void lock_release(struct lock *lock)
 {
+	enum intr_level old_level;
+
 	ASSERT(lock != NULL);
 	ASSERT(lock_held_by_current_thread(lock));
+
+	old_level = intr_disable();
+	list_remove(&lock->elem);
+	lock->holder->donated_tickets -= lock->donated_tickets;
 	if (!thread_mlfqs)
-	{
-		remove_donations(lock);
 		update_donate_priority();
-		// donate-one passed
-		// lock->holder->priority = lock->holder->origin_priority;
-	}
 
 	lock->holder = NULL;
 	sema_up(&lock->semaphore);
+	intr_set_level(old_level);
 }
 
-void remove_donations(struct lock *lock)
+/**
+ * @brief 현재 쓰레드의 우선순위를 원래 우선순위와 donation 받은 우선순위로 다시 계산하는 함수
+ *
+ * NOTE: [Improve] held_locks는 max_priority 내림차순으로 정렬되어 있으므로
+ * 맨 앞의 lock만 보면 된다.
+ */
+void update_donate_priority(void)
 {
-	struct thread *lock_holder_t = lock->holder;
+	struct thread *curr = thread_current();
+	enum intr_level old_level = intr_disable();
+	int priority = curr->origin_priority;
 
-	struct list_elem *remove_elem = list_begin(&lock_holder_t->donations);
+	if (!list_empty(&curr->held_locks))
+	{
+		struct lock *top = list_entry(list_front(&curr->held_locks), struct lock, elem);
+		if (priority < top->max_priority)
+			priority = top->max_priority;
+	}
 
-	while (remove_elem != list_end(&lock_holder_t->donations))
+	/* 읽기 모드로 잡고 있는 rwlock을 기다리는 writer의 donation */
+	for (int i = 0; i < RW_HOLD_MAX; i++)
 	{
-		struct thread *remove_t = list_entry(remove_elem, struct thread, donation_elem);
-		if (remove_t->wait_on_lock == lock)
-		{
-			remove_elem = list_remove(&remove_t->donation_elem);
-		}
-		else
-		{
-			remove_elem = list_next(remove_elem);
-		}
+		struct rwlock *rw = curr->rw_holds[i].rwlock;
+
+		if (rw != NULL && rw->writer_waiting && priority < rw->lock.holder->priority)
+			priority = rw->lock.holder->priority;
 	}
+
+	/* cond_wait() 중에는 condition의 waiters에 들어 있을 수 있으므로 thread_update_priority()로 바꾼다. */
+	thread_update_priority(curr, priority);
+	intr_set_level(old_level);
 }
 
-void update_donate_priority(void)
+/* Returns true if the current thread holds LOCK, false
+   otherwise.  (Note that testing whether some other thread holds
+   a lock would be racy.) */
+bool lock_held_by_current_thread(const struct lock *lock)
+{
+	ASSERT(lock != NULL);
+
+	return lock->holder == thread_current();
+}
+
+/* Number of times mutex_fast_acquire() polls a mutex whose
+   holder is running on another CPU before it blocks. */
+#define MUTEX_FAST_SPIN 128
+
+/* Statistics. */
+static long long mutex_fast_uncontended; /* # of acquisitions without waiting. */
+static long long mutex_fast_spun;		 /* # of acquisitions after spinning. */
+static long long mutex_fast_blocked;	 /* # of acquisitions after blocking. */
+
+/* Initializes MUTEX.  Like a lock, a mutex_fast can be held by
+   at most a single thread and is not recursive. */
+void mutex_fast_init(struct mutex_fast *mutex)
+{
+	ASSERT(mutex != NULL);
+
+	mutex->holder = NULL;
+	heap_init(&mutex->waiters, wait_less, NULL);
+}
+
+/**
+ * @brief mutex_fast를 획득하는 함수
+ *
+ * 비어 있으면 인터럽트만 끈 채 holder를 설정하고 바로 돌아온다.
+ * holder가 다른 CPU에서 실행 중이면 곧 놓아줄 것을 기대하고 MUTEX_FAST_SPIN번까지
+ * 돌며 기다리고, 그렇지 않으면 바로 waiters에 들어가 잠든다.
+ * 단일 프로세서에서는 holder가 실행 중일 수 없으므로 돌지 않고 바로 잠든다.
+ * lock_acquire()와 달리 priority donation은 하지 않는다.
+ *
+ * @param mutex 획득할 mutex
+ */
+void mutex_fast_acquire(struct mutex_fast *mutex)
 {
 	struct thread *curr = thread_current();
+	enum intr_level old_level;
+	int spin;
+
+	ASSERT(mutex != NULL);
+	ASSERT(!intr_context());
+	ASSERT(mutex->holder != curr);
 
-	curr->priority = curr->origin_priority;
-	// why? = curr < list's priority consider
+	old_level = intr_disable();
+	if (mutex->holder == NULL)
+	{
+		mutex->holder = curr;
+		mutex_fast_uncontended++;
+		intr_set_level(old_level);
+		return;
+	}
 
-	if (!list_empty(&curr->donations))
+	for (spin = 0; spin < MUTEX_FAST_SPIN; spin++)
 	{
-		list_sort(&curr->donations, cmp_donation, 0);
-		struct thread *donate_t = list_entry(list_begin(&curr->donations), struct thread, donation_elem);
+		struct thread *holder = __atomic_load_n(&mutex->holder, __ATOMIC_ACQUIRE);
 
-		if (curr->priority < donate_t->priority)
+		if (holder == NULL)
 		{
-			curr->priority = donate_t->priority;
+			mutex->holder = curr;
+			mutex_fast_spun++;
+			intr_set_level(old_level);
+			return;
 		}
+		if (holder->status != THREAD_RUNNING)
+			break;
+		asm volatile("pause");
+	}
+
+	wait_heap_push(&mutex->waiters);
+	thread_block();
+
+	/* 깨어났지만 다른 쓰레드가 먼저 잡았다면 원래 순번으로 다시 기다린다. */
+	while (mutex->holder != NULL)
+	{
+		wait_heap_requeue(&mutex->waiters);
+		thread_block();
 	}
+	mutex->holder = curr;
+	mutex_fast_blocked++;
+	intr_set_level(old_level);
 }
 
-/* Returns true if the current thread holds LOCK, false
-   otherwise.  (Note that testing whether some other thread holds
-   a lock would be racy.) */
-bool lock_held_by_current_thread(const struct lock *lock)
+/* Tries to acquire MUTEX and returns true if successful or
+   false on failure.  This function will not sleep. */
+bool mutex_fast_try_acquire(struct mutex_fast *mutex)
 {
-	ASSERT(lock != NULL);
+	enum intr_level old_level;
+	bool success = false;
 
-	return lock->holder == thread_current();
+	ASSERT(mutex != NULL);
+	ASSERT(!mutex_fast_held_by_current_thread(mutex));
+
+	old_level = intr_disable();
+	if (mutex->holder == NULL)
+	{
+		mutex->holder = thread_current();
+		mutex_fast_uncontended++;
+		success = true;
+	}
+	intr_set_level(old_level);
+	return success;
 }
 
-/* One semaphore in a list. */
-struct semaphore_elem
+/* Releases MUTEX, which must be owned by the current thread,
+   and wakes up the highest-priority waiter, if any. */
+void mutex_fast_release(struct mutex_fast *mutex)
 {
-	struct list_elem elem;		/* List element. */
-	struct semaphore semaphore; /* This semaphore. */
-};
+	enum intr_level old_level;
+
+	ASSERT(mutex != NULL);
+	ASSERT(mutex_fast_held_by_current_thread(mutex));
+
+	old_level = intr_disable();
+	mutex->holder = NULL;
+	if (!heap_empty(&mutex->waiters))
+	{
+		thread_unblock(wait_heap_pop(&mutex->waiters));
+		thread_compare_yield();
+	}
+	intr_set_level(old_level);
+}
+
+/* Returns true if the current thread holds MUTEX, false
+   otherwise. */
+bool mutex_fast_held_by_current_thread(const struct mutex_fast *mutex)
+{
+	ASSERT(mutex != NULL);
+
+	return mutex->holder == thread_current();
+}
+
+/* Prints synchronization statistics. */
+void synch_print_stats(void)
+{
+	printf("Mutex: %lld uncontended, %lld after spinning, %lld after blocking\n",
+		   mutex_fast_uncontended, mutex_fast_spun, mutex_fast_blocked);
+}
+
+/* Initializes reader-writer lock RW. */
+void rw_init(struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	lock_init(&rw->lock);
+	list_init(&rw->readers);
+	sema_init(&rw->drain, 0);
+	rw->writer_waiting = false;
+}
+
+/* Returns the current thread's read hold of RW, or a null
+   pointer if it does not hold RW for reading. */
+static struct rw_hold *
+rw_find_hold(struct rwlock *rw)
+{
+	struct thread *curr = thread_current();
+
+	for (int i = 0; i < RW_HOLD_MAX; i++)
+		if (curr->rw_holds[i].rwlock == rw)
+			return &curr->rw_holds[i];
+	return NULL;
+}
+
+/**
+ * @brief rwlock을 읽기 모드로 획득하는 함수
+ *
+ * 내부 lock을 거쳐 들어오므로 writer가 잡고 있거나 기다리는 중이면
+ * lock_acquire()에서 writer에게 donation하며 기다린다.
+ * 등록을 마치면 내부 lock을 바로 놓아 다른 reader도 들어올 수 있게 한다.
+ * 이미 RW_HOLD_MAX개의 read hold를 가지고 있다면 쓰기 모드로 대신 잡는다.
+ *
+ * @param rw 획득할 rwlock
+ */
+void rw_read_acquire(struct rwlock *rw)
+{
+	struct rw_hold *hold;
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+	ASSERT(!rw_write_held_by_current_thread(rw));
+	ASSERT(rw_find_hold(rw) == NULL);
+
+	hold = rw_find_hold(NULL);
+	if (hold == NULL)
+	{
+		rw_write_acquire(rw);
+		return;
+	}
+
+	lock_acquire(&rw->lock);
+	old_level = intr_disable();
+	hold->rwlock = rw;
+	hold->thread = thread_current();
+	list_push_back(&rw->readers, &hold->elem);
+	intr_set_level(old_level);
+	lock_release(&rw->lock);
+}
+
+/**
+ * @brief 읽기 모드로 획득한 rwlock을 놓아주는 함수
+ *
+ * 마지막 reader라면 기다리는 writer를 깨운다.
+ * writer에게 donation 받았을 수 있으므로 우선순위를 되돌린다.
+ *
+ * @param rw 놓아줄 rwlock
+ */
+void rw_read_release(struct rwlock *rw)
+{
+	struct rw_hold *hold;
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+
+	hold = rw_find_hold(rw);
+	if (hold == NULL)
+	{
+		/* read hold가 모자라 쓰기 모드로 잡은 경우 */
+		rw_write_release(rw);
+		return;
+	}
+
+	old_level = intr_disable();
+	list_remove(&hold->elem);
+	hold->rwlock = NULL;
+	if (list_empty(&rw->readers) && rw->writer_waiting)
+	{
+		rw->writer_waiting = false;
+		sema_up(&rw->drain);
+	}
+
+	if (!thread_mlfqs)
+	{
+		update_donate_priority();
+		thread_compare_yield();
+	}
+	intr_set_level(old_level);
+}
+
+/**
+ * @brief rwlock을 쓰기 모드로 획득하는 함수
+ *
+ * 내부 lock을 잡아 새 reader를 막은 뒤, 남아 있는 reader들에게
+ * 자신의 우선순위를 donation하고 모두 나갈 때까지 기다린다.
+ * wait_on_rwlock을 통해 donation chain에 이어지므로 기다리는 동안 받은
+ * donation도 reader에게 전달되고, reader가 놓을 때 update_donate_priority()가 되돌린다.
+ *
+ * @param rw 획득할 rwlock
+ */
+void rw_write_acquire(struct rwlock *rw)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+	ASSERT(rw_find_hold(rw) == NULL);
+
+	lock_acquire(&rw->lock);
+
+	old_level = intr_disable();
+	while (!list_empty(&rw->readers))
+	{
+		rw->writer_waiting = true;
+		curr->wait_on_rwlock = rw;
+		if (!thread_mlfqs)
+			donate_priority();
+		sema_down(&rw->drain);
+	}
+	curr->wait_on_rwlock = NULL;
+	intr_set_level(old_level);
+}
+
+/* Releases RW, which must be held for writing by the current
+   thread. */
+void rw_write_release(struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+	ASSERT(rw_write_held_by_current_thread(rw));
+
+	lock_release(&rw->lock);
+}
+
+/* Returns true if the current thread holds RW for writing,
+   false otherwise. */
+bool rw_write_held_by_current_thread(const struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	return lock_held_by_current_thread(&rw->lock);
+}
 
 /* Initializes condition variable COND.  A condition variable
    allows one piece of  code to signal a condition and cooperating
@@ -343,7 +733,7 @@ void cond_init(struct condition *cond)
 {
 	ASSERT(cond != NULL);
 
-	list_init(&cond->waiters);
+	heap_init(&cond->waiters, wait_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -368,37 +758,26 @@ void cond_init(struct condition *cond)
    we need to sleep. */
 void cond_wait(struct condition *cond, struct lock *lock)
 {
-	struct semaphore_elem waiter;
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
 
 	ASSERT(cond != NULL);
 	ASSERT(lock != NULL);
 	ASSERT(!intr_context());
 	ASSERT(lock_held_by_current_thread(lock));
 
-	sema_init(&waiter.semaphore, 0);
-	list_push_back(&cond->waiters, &waiter.elem);
+	/* NOTE: [Improve] 쓰레드가 직접 condition의 waiters에 들어간다.
+	   lock_release()에서 양보하는 동안 signal을 받을 수도 있으므로
+	   아직 waiters에 남아 있을 때만 잠든다. */
+	old_level = intr_disable();
+	wait_heap_push(&cond->waiters);
 	lock_release(lock);
-	sema_down(&waiter.semaphore);
+	while (curr->wait_heap == &cond->waiters)
+		thread_block();
+	intr_set_level(old_level);
 	lock_acquire(lock);
 }
 
-bool cmp_condition(struct list_elem *a, struct list_elem *b, void *aux UNUSED)
-{
-	struct semaphore_elem *sa = list_entry(a, struct semaphore_elem, elem);
-	struct semaphore_elem *sb = list_entry(b, struct semaphore_elem, elem);
-
-	struct list *list_a = &(sa->semaphore.waiters);
-	struct list *list_b = &(sb->semaphore.waiters);
-
-	struct thread *a_thread = list_entry(list_begin(list_a), struct thread, elem);
-	struct thread *b_thread = list_entry(list_begin(list_b), struct thread, elem);
-
-	int priority_a = a_thread->priority;
-	int priority_b = b_thread->priority;
-
-	return priority_a > priority_b;
-}
-
 /* If any threads are waiting on COND (protected by LOCK), then
    this function signals one of them to wake up from its wait.
    LOCK must be held before calling this function.
@@ -414,15 +793,20 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED)
 	ASSERT(lock_held_by_current_thread(lock));
 
 	/**
-	 * NOTE: waiters 정렬
+	 * NOTE: [Improve] waiters는 우선순위 heap이므로 정렬 없이 맨 위 쓰레드를 깨운다.
 	 * part: priority-sync
 	 */
-	list_sort(&cond->waiters, cmp_priority_donation, NULL);
-	if (!list_empty(&cond->waiters))
-		list_sort(&cond->waiters, cmp_condition, 0);
-	sema_up(&list_entry(list_pop_front(&cond->waiters),
-						struct semaphore_elem, elem)
-				 ->semaphore);
+	enum intr_level old_level = intr_disable();
+	if (!heap_empty(&cond->waiters))
+	{
+		struct thread *t = wait_heap_pop(&cond->waiters);
+
+		/* cond_wait()에서 아직 잠들기 전이라면 waiters에서 빼기만 하면 된다. */
+		if (t->status == THREAD_BLOCKED)
+			thread_unblock(t);
+		thread_compare_yield();
+	}
+	intr_set_level(old_level);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -436,23 +820,61 @@ void cond_broadcast(struct condition *cond, struct lock *lock)
 	ASSERT(cond != NULL);
 	ASSERT(lock != NULL);
 
-	while (!list_empty(&cond->waiters))
+	while (!heap_empty(&cond->waiters))
 		cond_signal(cond, lock);
 }
 
-/**
- * @brief 두 쓰레드의 우선순위를 비교하는 함수
- *
- * @param a_ 첫 번째 리스트 요소
- * @param b_ 두 번째 리스트 요소
- * @param UNUSED 사용하지 않는 매개변수
- * @return true 첫 번째 쓰레드의 우선순위가 두 번째 쓰레드보다 높은 경우 true 반환
- * @return false 그렇지 않은 경우 false 반환
- */
-static bool cmp_priority_donation(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED)
+/* Returns true if waiter A should be woken up before waiter B:
+   it has a higher priority, or the same priority and it started
+   waiting earlier. */
+static bool
+wait_less(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED)
 {
-	struct thread *a = list_entry(a_, struct thread, d_elem);
-	struct thread *b = list_entry(b_, struct thread, d_elem);
+	const struct thread *a = heap_entry(a_, struct thread, wait_elem);
+	const struct thread *b = heap_entry(b_, struct thread, wait_elem);
 
-	return a->priority > b->priority;
+	if (a->priority != b->priority)
+		return a->priority > b->priority;
+	return a->wait_seq < b->wait_seq;
 }
+
+/* Adds the current thread to WAITERS.  Interrupts must be off. */
+static void
+wait_heap_push(struct heap *waiters)
+{
+	struct thread *curr = thread_current();
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	curr->wait_seq = next_wait_seq++;
+	curr->wait_heap = waiters;
+	heap_insert(waiters, &curr->wait_elem);
+}
+
+/* Adds the current thread back to WAITERS after it was woken up
+   but lost the race, keeping its original arrival order.
+   Interrupts must be off. */
+static void
+wait_heap_requeue(struct heap *waiters)
+{
+	struct thread *curr = thread_current();
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	curr->wait_heap = waiters;
+	heap_insert(waiters, &curr->wait_elem);
+}
+
+/* Removes the highest-priority thread from WAITERS, which must
+   not be empty, and returns it.  Interrupts must be off. */
+static struct thread *
+wait_heap_pop(struct heap *waiters)
+{
+	struct thread *t = heap_entry(heap_pop_min(waiters), struct thread, wait_elem);
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	t->wait_heap = NULL;
+	return t;
+}
+
@@ -1,18 +1,22 @@
 #include "threads/thread.h"
 #include <debug.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "threads/workqueue.h"
 #include "intrinsic.h"
 #include "threads/fixed_point.h"
 #include "threads/malloc.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -26,17 +30,51 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* ready_bitmap이 우선순위마다 한 비트를 사용하므로 우선순위는 64단계를 넘을 수 없다. */
+#if PRI_MAX - PRI_MIN + 1 > 64
+#error ready_bitmap requires at most 64 priority levels
+#endif
 
-/* NOTE: [1.1] 상태가 THREAD_BLOCKED인 쓰레드들의 리스트 */
-static struct list sleep_list;
+/* NOTE: [Improve] 우선순위별 ready 큐 (O(1) 스케줄러)
+   THREAD_READY 상태의 쓰레드들을 우선순위마다 별도의 리스트에 FIFO로 담는다.
+   ready_bitmap의 i번째 비트는 ready_queue[i]가 비어있지 않음을 나타내므로
+   삽입, 삭제, 최고 우선순위 조회가 모두 상수 시간에 끝난다. */
+static struct list ready_queue[PRI_MAX + 1];
+static uint64_t ready_bitmap;
+static size_t ready_cnt; /* ready 큐에 담긴 쓰레드의 개수 */
+
+/* NOTE: [Improve] stride 스케줄러의 ready 큐
+   -stride 모드에서는 pass가 가장 작은 쓰레드를 O(log n)에 고르기 위해
+   우선순위별 큐 대신 pass 순서의 heap을 사용한다.
+   stride_pass는 마지막으로 선택된 쓰레드의 pass로, 깨어난 쓰레드의 pass 하한이다. */
+static struct heap stride_heap;
+static uint64_t stride_pass;
+
+/* NOTE: [Improve] EDF 스케줄링 클래스의 ready 큐
+   EDF 쓰레드는 다른 모든 쓰레드보다 먼저 실행되며, 그 중에서는 절대 deadline이
+   가장 이른 쓰레드가 먼저다. edf_util은 EDF 쓰레드들의 runtime/period 합(1/1000 단위)이다. */
+static struct heap edf_heap;
+static int edf_util;
+
+/* NOTE: [Improve] sleep 중인 쓰레드들을 담는 계층형 타이밍 휠
+   level L의 슬롯 하나는 64^L tick 길이의 구간을 나타낸다.
+   깨어날 시간이 가까운 쓰레드는 level 0에, 먼 쓰레드는 상위 level에 담기고,
+   상위 슬롯의 구간이 시작되는 tick에 그 슬롯의 쓰레드들을 아래 level로 내려보낸다(cascade).
+   따라서 삽입은 O(1)이고, 매 tick에는 만료되는 슬롯만 확인한다. */
+#define WHEEL_BITS 6						/* level당 슬롯 개수의 log2 */
+#define WHEEL_SIZE (1 << WHEEL_BITS)		/* level당 슬롯 개수 */
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4						/* level 개수 */
+#define WHEEL_SPAN (1LL << (WHEEL_BITS * WHEEL_LEVELS)) /* 휠이 표현하는 최대 tick 범위 */
+
+static struct list sleep_wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static uint64_t sleep_wheel_map[WHEEL_LEVELS]; /* 비어있지 않은 슬롯의 비트맵 */
+static int64_t wheel_tick;					   /* 휠이 아직 처리하지 않은 가장 이른 tick */
 
 /* NOTE: [Improve] 모든 쓰레드를 담는 리스트 */
 static struct list all_list;
 
-/* 쓰레드들의 wakeup_tick 중 최소값을 저장하는 전역변수 */
+/* 타이밍 휠에서 다음으로 처리할 일(깨우기 또는 cascade)이 생기는 tick */
 static int64_t global_tick;
 
 /* Idle thread. */
@@ -46,28 +84,73 @@ static struct thread *idle_thread;
 static struct thread *initial_thread;
 
 /* Lock used by allocate_tid(). */
-static struct lock tid_lock;
+static struct mutex_fast tid_lock;
 
 /* Thread destruction requests */
 static struct list destruction_req;
 
+/* NOTE: [Improve] 죽은 쓰레드의 페이지를 system_wq에서 해제하는 work */
+static struct work reap_work;
+
+/* NOTE: [Improve] F12 키에서 요청한 통계 출력을 system_wq에서 하는 work */
+static struct work dump_stats_work;
+
+/* NOTE: [Improve] 쓰레드 페이지 캐시
+   죽은 쓰레드의 페이지를 palloc에 돌려주지 않고 최대 thread_cache_max개까지 보관했다가
+   thread_create()에서 재사용한다. init_thread()가 struct thread를 초기화하므로
+   페이지 전체를 0으로 채우지 않는다. 페이지가 모자라면 palloc이
+   thread_cache_shrink()를 불러 캐시를 비운다. */
+size_t thread_cache_max = 8;		/* 캐시할 최대 페이지 수, -tcache 옵션 */
+static struct list thread_cache;	/* 캐시된 페이지 리스트 */
+static size_t thread_cache_cnt;		/* 캐시된 페이지 수 */
+static long long thread_cache_hits; /* 캐시에서 할당한 횟수 */
+static long long thread_cache_misses; /* palloc에서 할당한 횟수 */
+
 /* Statistics. */
 static long long idle_ticks;   /* # of timer ticks spent idle. */
 static long long kernel_ticks; /* # of timer ticks in kernel threads. */
 static long long user_ticks;   /* # of timer ticks in user programs. */
 
 /* Scheduling. */
-#define TIME_SLICE 4		  /* # of timer ticks to give each thread. */
 static unsigned thread_ticks; /* # of timer ticks since last yield. */
 
+/* NOTE: [Improve] 우선순위별 기본 time slice (tick), thread_set_slice()로 바꾼다. */
+static unsigned slice_table[PRI_MAX + 1] = {[PRI_MIN ... PRI_MAX] = TIME_SLICE};
+
+/* NOTE: [Improve] 문맥 교환 통계 */
+static long long voluntary_switches;   /* # of switches away from a thread that blocked. */
+static long long involuntary_switches; /* # of switches away from a preempted thread. */
+static long long lean_switches;		   /* # of switches that only restored callee-saved registers. */
+static long long full_switches;		   /* # of switches that restored a full intr_frame. */
+
 /* NOTE: [1.3] 시스템 부하 */
 fixed_point load_avg;
 
+/* NOTE: [Improve] MLFQS 점진적 재계산을 위한 데이터
+   - mlfqs_dirty_list: 마지막 우선순위 재계산 이후 recent_cpu가 바뀐 쓰레드들
+   - mlfqs_seconds: 부팅 후 recent_cpu 감쇄가 일어난 횟수(초)
+   - decay_hist: 최근 DECAY_HIST_SIZE초 동안의 감쇄율
+   - decay_a, decay_b: s초 시점의 recent_cpu r을 지금 시점의 값
+	 decay_a * r + nice * decay_b 로 옮기는 계수 (s % DECAY_HIST_SIZE 번째 칸).
+	 매초 모든 칸에 그 초의 감쇄를 합성해 두므로, block된 쓰레드는 깨어날 때
+	 잠든 시간과 관계없이 한 번에 밀린 감쇄를 적용한다. */
+#define DECAY_HIST_SIZE 64
+static struct list mlfqs_dirty_list;
+static int64_t mlfqs_seconds;
+static fixed_point decay_hist[DECAY_HIST_SIZE];
+static fixed_point decay_a[DECAY_HIST_SIZE];
+static fixed_point decay_b[DECAY_HIST_SIZE];
+
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If false (default), pick threads by priority.
+   If true, use stride scheduler.
+   Controlled by kernel command-line option "-stride". */
+bool thread_stride;
+
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
@@ -76,10 +159,30 @@ static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
-
-static int64_t get_min_tick(void);
-static int set_global_tick(int64_t tick);
-static bool wakeup_less(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
+static void schedule_account(struct thread *curr, struct thread *next);
+void switch_threads(uint64_t *cur_rsp, uint64_t next_rsp, struct intr_frame *next_tf);
+static void reap_dead_threads(void *aux);
+static void dump_stats_work_func(void *aux);
+static struct thread *thread_page_alloc(void);
+static void thread_page_free(struct thread *t);
+static size_t thread_cache_shrink(void);
+
+static void ready_queue_push(struct thread *t);
+static void ready_queue_remove(struct thread *t);
+static struct thread *ready_queue_pop(void);
+static int ready_queue_max_priority(void);
+static bool stride_less(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED);
+static bool edf_less(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED);
+static int edf_util_of(int64_t runtime, int64_t period);
+static void edf_replenish(struct thread *t, int64_t now);
+
+static void mlfqs_mark_dirty(struct thread *t);
+static bool mlfqs_catch_up(struct thread *t);
+
+static void sleep_wheel_insert(struct thread *t);
+static void sleep_wheel_cascade(void);
+static void sleep_wheel_expire(void);
+static int64_t sleep_wheel_next(void);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -124,12 +227,26 @@ void thread_init(void)
 	lgdt(&gdt_ds);
 
 	/* Init the globla thread context */
-	lock_init(&tid_lock);
-	list_init(&ready_list);
-	list_init(&sleep_list); /* sleep list 초기화 */
+	mutex_fast_init(&tid_lock);
+	for (int i = PRI_MIN; i <= PRI_MAX; i++)
+		list_init(&ready_queue[i]);
+	ready_bitmap = 0;
+	heap_init(&stride_heap, stride_less, NULL);
+	heap_init(&edf_heap, edf_less, NULL);
+	ready_cnt = 0;
+	for (int level = 0; level < WHEEL_LEVELS; level++) /* 타이밍 휠 초기화 */
+		for (int slot = 0; slot < WHEEL_SIZE; slot++)
+			list_init(&sleep_wheel[level][slot]);
 	list_init(&all_list);	/* NOTE: [Improve] all list 초기화 */
+	list_init(&mlfqs_dirty_list);
+	decay_a[0] = int_to_fp(1); /* 0초 시점의 변환은 항등 변환 */
 	list_init(&destruction_req);
+	work_init(&reap_work, reap_dead_threads, NULL);
+	work_init(&dump_stats_work, dump_stats_work_func, NULL);
+	list_init(&thread_cache);
+	palloc_register_shrinker(thread_cache_shrink);
 
+	wheel_tick = 0;
 	global_tick = INT64_MAX; /* global tick 초기화 */
 	load_avg = int_to_fp(0); /* NOTE: [1.3] load_avg 초기화 */
 
@@ -172,9 +289,72 @@ void thread_tick(void)
 	else
 		kernel_ticks++;
 
+	/* NOTE: [Improve] EDF 쓰레드는 budget을 다 쓰면 다음 주기까지 멈춘다. */
+	if (t->edf && --t->edf_budget <= 0 && !t->edf_throttled)
+	{
+		t->edf_throttled = true;
+		t->edf_overruns++;
+		intr_yield_on_return();
+	}
+
+	/* NOTE: [Improve] stride 스케줄러는 실행한 만큼 pass를 증가시킨다. */
+	if (thread_stride && t != idle_thread)
+	{
+		ASSERT(t->tickets + t->donated_tickets > 0);
+		t->pass += STRIDE1 / (t->tickets + t->donated_tickets);
+	}
+
+	/* NOTE: [Improve] 쓰레드별 실행 시간, donation 받은 시간 기록 */
+	t->stats.run_ticks++;
+	if (!thread_mlfqs && t->priority > t->origin_priority)
+		t->stats.boosted_ticks++;
+
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (++thread_ticks >= thread_slice(t))
+	{
+		t->stats.preempted = true;
 		intr_yield_on_return();
+	}
+}
+
+/**
+ * @brief 우선순위 PRIORITY의 기본 time slice를 TICKS로 정하는 함수
+ *
+ * PRIORITY가 음수이면 모든 우선순위에 적용한다. 부팅 시 "-slice" 옵션에서 호출된다.
+ *
+ * @param priority 대상 우선순위, 음수이면 전체
+ * @param ticks 새 time slice (tick), 1 이상
+ * @return 인자가 올바르면 true
+ */
+bool thread_set_slice(int priority, unsigned ticks)
+{
+	int p;
+
+	if (ticks == 0 || priority > PRI_MAX)
+		return false;
+
+	for (p = PRI_MIN; p <= PRI_MAX; p++)
+		if (priority < 0 || p == priority)
+			slice_table[p] = ticks;
+	return true;
+}
+
+/**
+ * @brief 쓰레드 T의 실제 time slice를 구하는 함수
+ *
+ * 현재 우선순위의 기본 time slice에 T의 배율 2^slice_shift를 곱한다. 최소 1 tick이다.
+ * 배율만 저장하므로 donation이나 MLFQS 재계산으로 우선순위가 바뀌면 slice도 따라 바뀐다.
+ */
+unsigned thread_slice(const struct thread *t)
+{
+	unsigned base = slice_table[t->priority];
+	unsigned slice;
+
+	if (t->slice_shift >= 0)
+		slice = base << t->slice_shift;
+	else
+		slice = base >> -t->slice_shift;
+	return slice > 0 ? slice : 1;
 }
 
 /* Prints thread statistics. */
@@ -182,6 +362,121 @@ void thread_print_stats(void)
 {
 	printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 		   idle_ticks, kernel_ticks, user_ticks);
+	printf("Thread: %lld voluntary switches, %lld involuntary switches\n",
+		   voluntary_switches, involuntary_switches);
+	printf("Thread: %lld lean switches, %lld full switches\n",
+		   lean_switches, full_switches);
+	printf("Thread: page cache %lld hits, %lld misses, %zu cached\n",
+		   thread_cache_hits, thread_cache_misses, thread_cache_cnt);
+	thread_dump_stats();
+}
+
+/* thread_dump_stats()가 인터럽트를 끈 채 한 쓰레드에서 복사해 두는 통계 */
+struct thread_dump
+{
+	char name[16];
+	tid_t tid;
+	struct thread_stats stats;
+	unsigned slice;
+	bool edf;
+	long long edf_jobs, edf_misses, edf_overruns;
+};
+
+/* thread_dump_stats()가 한 번 인터럽트를 끌 때 복사하는 쓰레드 수 */
+#define THREAD_DUMP_BATCH 4
+
+/* 살아 있는 쓰레드 중 tid가 LAST보다 큰 쓰레드를 tid 순으로 최대
+   THREAD_DUMP_BATCH개 골라 DUMPS에 복사하고, 복사한 개수를 반환한다.
+   all_list는 인터럽트를 꺼서 보호하므로 한 번의 순회 동안 인터럽트를 끈다. */
+static int thread_dump_batch(tid_t last, struct thread_dump dumps[THREAD_DUMP_BATCH])
+{
+	struct thread *batch[THREAD_DUMP_BATCH];
+	enum intr_level old_level = intr_disable();
+	struct list_elem *e;
+	int cnt = 0;
+	int i;
+
+	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e))
+	{
+		struct thread *t = list_entry(e, struct thread, all_elem);
+
+		if (t->tid <= last || (cnt == THREAD_DUMP_BATCH && t->tid >= batch[cnt - 1]->tid))
+			continue;
+
+		/* batch를 tid 오름차순으로 유지하며 삽입한다. */
+		if (cnt < THREAD_DUMP_BATCH)
+			cnt++;
+		for (i = cnt - 1; i > 0 && batch[i - 1]->tid > t->tid; i--)
+			batch[i] = batch[i - 1];
+		batch[i] = t;
+	}
+	for (i = 0; i < cnt; i++)
+	{
+		struct thread *t = batch[i];
+		struct thread_dump *dump = &dumps[i];
+
+		strlcpy(dump->name, t->name, sizeof dump->name);
+		dump->tid = t->tid;
+		dump->stats = t->stats;
+		dump->slice = thread_slice(t);
+		dump->edf = t->edf;
+		dump->edf_jobs = t->edf_jobs;
+		dump->edf_misses = t->edf_misses;
+		dump->edf_overruns = t->edf_overruns;
+	}
+	intr_set_level(old_level);
+	return cnt;
+}
+
+static void dump_stats_work_func(void *aux UNUSED)
+{
+	thread_dump_stats();
+}
+
+/**
+ * @brief 살아 있는 모든 쓰레드의 스케줄러 통계를 출력하는 함수
+ *
+ * 종료 시 print_stats()와 키보드의 디버그 키(F12)에서 호출된다.
+ * 인터럽트를 끈 채 THREAD_DUMP_BATCH개씩 통계만 복사하고, 출력은 인터럽트를 켠 채로 한다.
+ * 인터럽트 컨텍스트에서 호출되면 system_wq로 미룬다.
+ */
+void thread_dump_stats(void)
+{
+	struct thread_dump dumps[THREAD_DUMP_BATCH];
+	tid_t last = TID_ERROR;
+	int cnt, n;
+
+	if (intr_context())
+	{
+		work_submit(&system_wq, &dump_stats_work);
+		return;
+	}
+
+	while ((cnt = thread_dump_batch(last, dumps)) > 0)
+	{
+		for (n = 0; n < cnt; n++)
+		{
+			const struct thread_dump *dump = &dumps[n];
+			const struct thread_stats *st = &dump->stats;
+			int i;
+
+			printf("  %-16s tid %3d: %" PRId64 " run ticks, %" PRId64 " boosted, "
+				   "%lld/%lld vol/invol switches, %" PRId64 " ticks overslept in %lld sleeps\n",
+				   dump->name, dump->tid, st->run_ticks, st->boosted_ticks,
+				   st->voluntary_switches, st->involuntary_switches,
+				   st->sleep_overshoot, st->sleep_cnt);
+			printf("  %-16s slice %u ticks, %lld slice expiries\n",
+				   "", dump->slice, st->slice_expiries);
+			printf("  %-16s ready wait:", "");
+			for (i = 0; i < THREAD_WAIT_BUCKETS; i++)
+				printf(" %lld", st->ready_wait[i]);
+			printf("\n");
+			if (dump->edf)
+				printf("  %-16s edf: %lld jobs, %lld deadline misses, %lld overruns\n",
+					   "", dump->edf_jobs, dump->edf_misses, dump->edf_overruns);
+		}
+		last = dumps[cnt - 1].tid;
+	}
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -208,7 +503,7 @@ tid_t thread_create(const char *name, int priority,
 	ASSERT(function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page(PAL_ZERO);
+	t = thread_page_alloc();
 	if (t == NULL)
 		return TID_ERROR;
 
@@ -216,6 +511,9 @@ tid_t thread_create(const char *name, int priority,
 	init_thread(t, name, priority);
 	tid = t->tid = allocate_tid();
 
+	/* NOTE: [Improve] 자식은 부모의 stride 티켓 수를 물려받는다. */
+	t->tickets = thread_current()->tickets;
+
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
 	t->tf.rip = (uintptr_t)kernel_thread;
@@ -244,7 +542,11 @@ tid_t thread_create(const char *name, int priority,
 	t->fdt = palloc_get_page(PAL_ZERO);
 	if (t->fdt == NULL)
 	{
-		palloc_free_page(t);
+		enum intr_level old_level = intr_disable();
+		list_remove(&t->all_elem);
+		list_remove(&t->c_elem);
+		intr_set_level(old_level);
+		thread_page_free(t);
 		return TID_ERROR;
 	}
 
@@ -291,11 +593,21 @@ void thread_unblock(struct thread *t)
 	old_level = intr_disable();
 	ASSERT(t->status == THREAD_BLOCKED);
 
-	/**
-	 * NOTE: ready_list에 우선순위 순으로 삽입
-	 * part: priority-insert-ordered
-	 */
-	list_insert_ordered(&ready_list, &t->elem, compare_priority, NULL);
+	/* NOTE: [Improve] sleep 동안 밀린 recent_cpu 감쇄를 적용하고 우선순위 재계산 */
+	if (thread_mlfqs && mlfqs_catch_up(t))
+		thread_calc_priority(t);
+
+	/* NOTE: [Improve] EDF 쓰레드는 주기가 지났다면 새 주기를 시작한다. */
+	if (t->edf)
+		edf_replenish(t, timer_ticks());
+
+	/* NOTE: [Improve] 오래 잠들어 있던 쓰레드가 CPU를 독점하지 않도록 pass를 따라잡게 한다. */
+	if (t->pass < stride_pass)
+		t->pass = stride_pass;
+
+	/* NOTE: [Improve] 우선순위에 해당하는 ready 큐의 맨 뒤에 삽입 */
+	t->stats.ready_since = timer_ticks();
+	ready_queue_push(t);
 	t->status = THREAD_READY;
 	intr_set_level(old_level);
 }
@@ -341,6 +653,11 @@ void thread_exit(void)
 #ifdef USERPROG
 	process_exit();
 #endif
+	/* NOTE: [Improve] EDF 쓰레드가 차지하던 utilization을 돌려준다. */
+	if (thread_current()->edf)
+		thread_clear_deadline();
+	fpu_release(thread_current());
+
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable();
@@ -348,20 +665,57 @@ void thread_exit(void)
 	NOT_REACHED();
 }
 
+/**
+ * @brief ready 큐에 현재 쓰레드보다 우선순위가 높은 쓰레드가 있으면 CPU를 양보하는 함수
+ *
+ * 인터럽트 컨텍스트(e.g. 디스크 인터럽트의 sema_up)에서 호출되면
+ * 바로 양보할 수 없으므로 인터럽트 리턴 시점에 양보하도록 예약한다.
+ */
 void thread_compare_yield(void)
 {
 	if (thread_current() == idle_thread)
-	{
 		return;
+
+	/* NOTE: [Improve] EDF 쓰레드가 ready 상태라면 일반 쓰레드와 deadline이 더 늦은 EDF 쓰레드는 양보한다. */
+	if (!heap_empty(&edf_heap))
+	{
+		struct thread *first = heap_entry(heap_min(&edf_heap), struct thread, edf_elem);
+		if (!thread_current()->edf || first->edf_deadline < thread_current()->edf_deadline)
+		{
+			thread_current()->stats.preempted = true;
+			if (intr_context())
+				intr_yield_on_return();
+			else
+				thread_yield();
+			return;
+		}
 	}
+	if (thread_current()->edf)
+		return;
 
-	if (list_empty(&ready_list))
+	/* NOTE: [Improve] stride 모드에서는 pass가 더 작은 쓰레드가 있으면 양보한다. */
+	if (thread_stride)
 	{
+		if (!heap_empty(&stride_heap)
+			&& heap_entry(heap_min(&stride_heap), struct thread, stride_elem)->pass < thread_current()->pass)
+		{
+			thread_current()->stats.preempted = true;
+			if (intr_context())
+				intr_yield_on_return();
+			else
+				thread_yield();
+		}
 		return;
 	}
 
-	if (thread_current()->priority < list_entry(list_begin(&ready_list), struct thread, elem)->priority)
-		thread_yield();
+	if (thread_current()->priority < ready_queue_max_priority())
+	{
+		thread_current()->stats.preempted = true;
+		if (intr_context())
+			intr_yield_on_return();
+		else
+			thread_yield();
+	}
 }
 
 /**
@@ -380,12 +734,24 @@ void thread_yield(void)
 
 	old_level = intr_disable();
 
-	/**
-	 * NOTE: ready_list에 우선순위 순으로 삽입
-	 * part: priority-insert-ordered
-	 */
+	/* NOTE: [Improve] budget을 다 쓴 EDF 쓰레드는 다음 주기가 시작될 때까지 잠든다.
+	   cond_wait() 도중이라 waiters heap에 들어 있다면 이번에는 그냥 양보한다. */
+	if (curr->edf_throttled && curr->wait_heap == NULL)
+	{
+		curr->wakeup_tick = curr->edf_period_start + curr->edf_period;
+		sleep_wheel_insert(curr);
+		global_tick = sleep_wheel_next();
+		do_schedule(THREAD_BLOCKED);
+		intr_set_level(old_level);
+		return;
+	}
+
+	/* NOTE: [Improve] 우선순위에 해당하는 ready 큐의 맨 뒤에 삽입 */
 	if (curr != idle_thread)
-		list_insert_ordered(&ready_list, &curr->elem, compare_priority, NULL);
+	{
+		curr->stats.ready_since = timer_ticks();
+		ready_queue_push(curr);
+	}
 	do_schedule(THREAD_READY);
 	intr_set_level(old_level);
 }
@@ -406,47 +772,40 @@ void thread_sleep(int64_t wakeup_tick)
 
 	if (curr != idle_thread)
 	{
-		curr->wakeup_tick = wakeup_tick; /* local tick 설정 */
-		if (wakeup_tick < global_tick)	 /* 필요시 global_tick 갱신 */
-			set_global_tick(wakeup_tick);
-		list_push_back(&sleep_list, &curr->elem); /* sleep_list에 쓰레드 삽입 */
+		curr->stats.sleeping = true;
+		curr->wakeup_tick = wakeup_tick;   /* local tick 설정 */
+		sleep_wheel_insert(curr);		   /* 타이밍 휠에 쓰레드 삽입 */
+		global_tick = sleep_wheel_next(); /* global_tick 갱신 */
 	}
 	do_schedule(THREAD_BLOCKED); /* 현재 쓰레드를 blocked 상태로 스케줄링 */
 	intr_set_level(old_level);	 /* 이전 인터럽트 복원 */
 }
 
 /**
- * @brief 주어진 틱 시간에 깨어날 쓰레드를 깨우는 함수
+ * @brief 주어진 틱 시간까지 깨어나야 할 쓰레드를 깨우는 함수
+ *
+ * global_tick 이전의 tick에는 처리할 일이 없으므로 건너뛰고,
+ * 처리할 일이 있는 tick에서만 cascade와 만료 처리를 수행한다.
  *
  * @param curr_tick 현재 시간을 나타내는 틱 값
  */
 void thread_wakeup(int64_t curr_tick)
 {
-	if (global_tick > curr_tick) /* 현재 tick이 global tick보다 작은 경우 함수 종료 */
-		return;
-
-	if (list_empty(&sleep_list)) /* sleep_list가 비어있는 경우 함수 종료 */
-		return;
-
-	struct list_elem *e;
-	struct thread *t;
+	bool woken = global_tick <= curr_tick;
 
-	e = list_begin(&sleep_list);
-	while (e != list_end(&sleep_list)) /* sleep_list를 순회하며 깨어날 쓰레드 처리 */
+	while (global_tick <= curr_tick)
 	{
-		t = list_entry(e, struct thread, elem); /* 해당 elem와 매핑된 thread */
-
-		if (t->wakeup_tick <= curr_tick) /* wakeup 필요 */
-		{
-			e = list_remove(e); /* sleep_list에서 제거 */
-			thread_unblock(t);	/* 쓰레드 block 해제 후 */
-			// thread_compare_yield();
-			set_global_tick(get_min_tick()); /* global_tick 갱신 */
-		}
-		else
-			e = e->next;
+		wheel_tick = global_tick; /* 그 사이의 tick에는 처리할 일이 없다 */
+		sleep_wheel_cascade();
+		sleep_wheel_expire();
+		wheel_tick++;
+		global_tick = sleep_wheel_next(); /* global_tick 갱신 */
 	}
-	set_global_tick(get_min_tick()); /* global_tick 갱신 */
+	wheel_tick = curr_tick + 1;
+
+	/* NOTE: [Improve] 깨어난 쓰레드가 더 급하다면 인터럽트 리턴 시 바로 양보한다. */
+	if (woken)
+		thread_compare_yield();
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
@@ -457,24 +816,21 @@ void thread_set_priority(int new_priority)
 		return;
 
 	/* NOTE: donation 고려하여 우선순위 설정 */
-	if (thread_current()->origin_priority == thread_current()->priority)
-		thread_current()
-			->priority = new_priority;
 	thread_current()->origin_priority = new_priority;
 
 	/**
-	 * NOTE: Reorder the ready_list
+	 * NOTE: 우선순위가 낮아졌다면 더 높은 ready 쓰레드에게 양보
 	 * part: priority-insert-ordered
 	 */
-	// if(thread_current()->wait_on_lock != NULL){
-	// 	update_donate_priority(&thread_current()->wait_on_lock);
-	// }
 	update_donate_priority();
-	if (!list_empty(&ready_list))
-	{
-		struct thread *t = list_entry(list_front(&ready_list), struct thread, elem);
-		thread_compare_yield();
-	}
+	thread_compare_yield();
+}
+
+/* NOTE: [Improve] sleep 중인 쓰레드를 깨우기 위해 타이머가 처리해야 할 다음 tick을 반환한다.
+   sleep 중인 쓰레드가 없으면 INT64_MAX를 반환한다. */
+int64_t thread_next_wakeup(void)
+{
+	return global_tick;
 }
 
 /* Returns the current thread's priority. */
@@ -496,6 +852,96 @@ void thread_set_nice(int new_nice)
 	intr_set_level(old_level);
 }
 
+/**
+ * @brief 현재 쓰레드를 EDF 클래스로 옮기는 함수
+ *
+ * 매 PERIOD tick마다 RUNTIME tick의 실행 시간을 주기 시작부터 DEADLINE tick 안에 보장받는다.
+ * 모든 EDF 쓰레드의 runtime/period 합이 EDF_UTIL_MAX를 넘으면 거절한다(admission control).
+ * 이미 EDF 쓰레드라면 매개변수만 바꾼다.
+ *
+ * @return true 받아들여진 경우
+ * @return false 매개변수가 잘못되었거나 admission control에서 거절된 경우
+ */
+bool thread_set_deadline(int64_t runtime, int64_t period, int64_t deadline)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+	int util, old_util;
+
+	if (runtime <= 0 || runtime > deadline || deadline > period)
+		return false;
+
+	util = edf_util_of(runtime, period);
+	old_level = intr_disable();
+	old_util = curr->edf ? edf_util_of(curr->edf_runtime, curr->edf_period) : 0;
+	if (edf_util - old_util + util > EDF_UTIL_MAX)
+	{
+		intr_set_level(old_level);
+		return false;
+	}
+	edf_util += util - old_util;
+
+	curr->edf = true;
+	curr->edf_throttled = false;
+	curr->edf_runtime = runtime;
+	curr->edf_period = period;
+	curr->edf_rel_deadline = deadline;
+	curr->edf_period_start = INT64_MIN / 2;
+	edf_replenish(curr, timer_ticks());
+	intr_set_level(old_level);
+	return true;
+}
+
+/* NOTE: [Improve] Returns the current thread to its normal
+   scheduling class. */
+void thread_clear_deadline(void)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level = intr_disable();
+
+	if (curr->edf)
+	{
+		edf_util -= edf_util_of(curr->edf_runtime, curr->edf_period);
+		curr->edf = false;
+		curr->edf_throttled = false;
+	}
+	intr_set_level(old_level);
+	thread_compare_yield();
+}
+
+/* NOTE: [Improve] Returns the number of jobs of the current
+   thread that finished after their deadline. */
+long long thread_get_deadline_misses(void)
+{
+	return thread_current()->edf_misses;
+}
+
+/* NOTE: [Improve] Returns the current thread's stride tickets. */
+int thread_get_tickets(void)
+{
+	return thread_current()->tickets;
+}
+
+/**
+ * @brief 현재 쓰레드의 stride 티켓 수를 바꾸는 함수
+ *
+ * 티켓 수는 모든 모드에서 저장되지만 -stride 모드에서만 스케줄링에 쓰인다.
+ *
+ * @param tickets 새로운 티켓 수 (TICKETS_MIN 이상 TICKETS_MAX 이하)
+ * @return int 이전 티켓 수, TICKETS가 범위를 벗어나면 -1
+ */
+int thread_set_tickets(int tickets)
+{
+	struct thread *curr = thread_current();
+	int old_tickets = curr->tickets;
+
+	if (tickets < TICKETS_MIN || tickets > TICKETS_MAX)
+		return -1;
+
+	curr->tickets = tickets;
+	return old_tickets;
+}
+
 /** NOTE: [1.3]
  * @brief 현재 실행 중인 쓰레드의 nice 값을 반환하는 함수
  *
@@ -562,8 +1008,21 @@ idle(void *idle_started_ UNUSED)
 	{
 		/* Let someone else run. */
 		intr_disable();
+		timer_idle_exit();
 		thread_block();
 
+		/* NOTE: [Improve] 실행할 쓰레드가 없는 동안 미리 0으로 채운 페이지를 만든다.
+		   한 페이지마다 ready 큐를 확인해서 쓰레드가 생기면 바로 양보한다. */
+		intr_enable();
+		while (ready_cnt == 0 && palloc_zero_idle())
+			continue;
+		intr_disable();
+		if (ready_cnt > 0)
+			continue;
+
+		/* NOTE: [Improve] tickless 모드에서는 다음 wakeup 시점까지 주기적 tick을 멈춘다. */
+		timer_idle_enter();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -596,6 +1055,8 @@ kernel_thread(thread_func *function, void *aux)
 static void
 init_thread(struct thread *t, const char *name, int priority)
 {
+	enum intr_level old_level;
+
 	ASSERT(t != NULL);
 	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
 	ASSERT(name != NULL);
@@ -608,15 +1069,21 @@ init_thread(struct thread *t, const char *name, int priority)
 	t->magic = THREAD_MAGIC;
 
 	/* NOTE: donation을 위한 데이터 초기화 */
-	list_init(&t->donations);
+	list_init(&t->held_locks);
 	t->origin_priority = priority;
 
+	/* NOTE: [Improve] stride 스케줄러를 위한 데이터 초기화 */
+	t->tickets = TICKETS_DEFAULT;
+
 	/* NOTE: [1.3] MLFQ를 위한 데이터 초기화 */
 	t->nice = 0;
 	t->recent_cpu = 0;
+	t->recent_cpu_sec = mlfqs_seconds;
 
 	/* NOTE: [Improve] 모든 쓰레드 생성 시 all_list에 추가 */
+	old_level = intr_disable();
 	list_push_back(&all_list, &t->all_elem);
+	intr_set_level(old_level);
 
 	/* NOTE: [2.3] 자식 리스트 초기화 */
 	list_init(&t->child_list);
@@ -631,10 +1098,184 @@ init_thread(struct thread *t, const char *name, int priority)
 static struct thread *
 next_thread_to_run(void)
 {
-	if (list_empty(&ready_list))
+	if (ready_cnt == 0)
 		return idle_thread;
 	else
-		return list_entry(list_pop_front(&ready_list), struct thread, elem);
+		return ready_queue_pop();
+}
+
+/* NOTE: [Improve] T를 자신의 우선순위에 해당하는 ready 큐의 맨 뒤에 삽입한다.
+   인터럽트가 비활성화된 상태에서 호출되어야 한다. */
+static void
+ready_queue_push(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	if (t->edf)
+	{
+		heap_insert(&edf_heap, &t->edf_elem);
+		ready_cnt++;
+		return;
+	}
+
+	if (thread_stride)
+	{
+		heap_insert(&stride_heap, &t->stride_elem);
+		ready_cnt++;
+		return;
+	}
+
+	list_push_back(&ready_queue[t->priority], &t->elem);
+	ready_bitmap |= 1ULL << t->priority;
+	ready_cnt++;
+}
+
+/* NOTE: [Improve] ready 큐에 있는 T를 큐에서 제거한다.
+   T->priority는 삽입될 때의 값과 같아야 한다. */
+static void
+ready_queue_remove(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(t->status == THREAD_READY);
+
+	if (t->edf)
+	{
+		heap_remove(&edf_heap, &t->edf_elem);
+		ready_cnt--;
+		return;
+	}
+
+	if (thread_stride)
+	{
+		heap_remove(&stride_heap, &t->stride_elem);
+		ready_cnt--;
+		return;
+	}
+
+	list_remove(&t->elem);
+	if (list_empty(&ready_queue[t->priority]))
+		ready_bitmap &= ~(1ULL << t->priority);
+	ready_cnt--;
+}
+
+/* NOTE: [Improve] 가장 높은 우선순위 큐의 맨 앞 쓰레드를 꺼내 반환한다.
+   ready 큐가 비어있으면 안 된다. */
+static struct thread *
+ready_queue_pop(void)
+{
+	int priority = ready_queue_max_priority();
+	struct thread *t;
+
+	if (!heap_empty(&edf_heap))
+	{
+		ready_cnt--;
+		return heap_entry(heap_pop_min(&edf_heap), struct thread, edf_elem);
+	}
+
+	if (thread_stride)
+	{
+		t = heap_entry(heap_pop_min(&stride_heap), struct thread, stride_elem);
+		stride_pass = t->pass;
+		ready_cnt--;
+		return t;
+	}
+
+	ASSERT(priority >= PRI_MIN);
+	t = list_entry(list_pop_front(&ready_queue[priority]), struct thread, elem);
+	if (list_empty(&ready_queue[priority]))
+		ready_bitmap &= ~(1ULL << priority);
+	ready_cnt--;
+	return t;
+}
+
+/* NOTE: [Improve] EDF heap에서 A가 B보다 먼저 실행되어야 하는지 반환한다. */
+static bool
+edf_less(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED)
+{
+	const struct thread *a = heap_entry(a_, struct thread, edf_elem);
+	const struct thread *b = heap_entry(b_, struct thread, edf_elem);
+
+	if (a->edf_deadline != b->edf_deadline)
+		return a->edf_deadline < b->edf_deadline;
+	return a->tid < b->tid;
+}
+
+/* NOTE: [Improve] RUNTIME/PERIOD를 1/1000 단위로 올림하여 반환한다. */
+static int
+edf_util_of(int64_t runtime, int64_t period)
+{
+	return (runtime * 1000 + period - 1) / period;
+}
+
+/* NOTE: [Improve] EDF 쓰레드 T의 현재 주기가 NOW 이전에 끝났다면 NOW에서 새 주기를 시작한다. */
+static void
+edf_replenish(struct thread *t, int64_t now)
+{
+	if (now < t->edf_period_start + t->edf_period)
+		return;
+
+	t->edf_period_start = now;
+	t->edf_deadline = now + t->edf_rel_deadline;
+	t->edf_budget = t->edf_runtime;
+	t->edf_throttled = false;
+}
+
+/* NOTE: [Improve] stride heap에서 A가 B보다 먼저 실행되어야 하는지 반환한다.
+   pass가 같으면 tid가 작은 쓰레드가 먼저다. */
+static bool
+stride_less(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED)
+{
+	const struct thread *a = heap_entry(a_, struct thread, stride_elem);
+	const struct thread *b = heap_entry(b_, struct thread, stride_elem);
+
+	if (a->pass != b->pass)
+		return a->pass < b->pass;
+	return a->tid < b->tid;
+}
+
+/* NOTE: [Improve] ready 큐에 있는 쓰레드 중 가장 높은 우선순위를 반환한다.
+   ready 큐가 비어있으면 PRI_MIN - 1을 반환한다. */
+static int
+ready_queue_max_priority(void)
+{
+	if (ready_bitmap == 0)
+		return PRI_MIN - 1;
+	return 63 - __builtin_clzll(ready_bitmap);
+}
+
+/**
+ * @brief 쓰레드 T의 (donation이 반영된) 우선순위를 PRIORITY로 변경하는 함수
+ *
+ * T가 ready 큐에 있다면 새로운 우선순위에 해당하는 큐로 옮기고,
+ * 동기화 객체의 waiters heap에 있다면 heap 안의 위치를 다시 잡는다.
+ * 우선순위별 ready 큐와 waiters heap을 유지하기 위해 priority를 바꿀 때는
+ * 반드시 이 함수를 사용해야 한다.
+ */
+void thread_update_priority(struct thread *t, int priority)
+{
+	enum intr_level old_level;
+
+	ASSERT(is_thread(t));
+	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+
+	old_level = intr_disable();
+	if (t->priority != priority)
+	{
+		bool ready = t->status == THREAD_READY;
+
+		/* NOTE: [Improve] waiters heap에 들어 있다면 heap 안의 위치도 다시 잡는다. */
+		if (ready)
+			ready_queue_remove(t);
+		if (t->wait_heap != NULL)
+			heap_remove(t->wait_heap, &t->wait_elem);
+		t->priority = priority;
+		if (t->wait_heap != NULL)
+			heap_insert(t->wait_heap, &t->wait_elem);
+		if (ready)
+			ready_queue_push(t);
+	}
+	intr_set_level(old_level);
 }
 
 /* Use iretq to launch the thread */
@@ -678,60 +1319,18 @@ void do_iret(struct intr_frame *tf)
 static void
 thread_launch(struct thread *th)
 {
-	uint64_t tf_cur = (uint64_t)&running_thread()->tf;
-	uint64_t tf = (uint64_t)&th->tf;
+	struct thread *curr = running_thread();
 	ASSERT(intr_get_level() == INTR_OFF);
 
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile(
-		/* Store registers that will be used. */
-		"push %%rax\n"
-		"push %%rbx\n"
-		"push %%rcx\n"
-		/* Fetch input once */
-		"movq %0, %%rax\n"
-		"movq %1, %%rcx\n"
-		"movq %%r15, 0(%%rax)\n"
-		"movq %%r14, 8(%%rax)\n"
-		"movq %%r13, 16(%%rax)\n"
-		"movq %%r12, 24(%%rax)\n"
-		"movq %%r11, 32(%%rax)\n"
-		"movq %%r10, 40(%%rax)\n"
-		"movq %%r9, 48(%%rax)\n"
-		"movq %%r8, 56(%%rax)\n"
-		"movq %%rsi, 64(%%rax)\n"
-		"movq %%rdi, 72(%%rax)\n"
-		"movq %%rbp, 80(%%rax)\n"
-		"movq %%rdx, 88(%%rax)\n"
-		"pop %%rbx\n" // Saved rcx
-		"movq %%rbx, 96(%%rax)\n"
-		"pop %%rbx\n" // Saved rbx
-		"movq %%rbx, 104(%%rax)\n"
-		"pop %%rbx\n" // Saved rax
-		"movq %%rbx, 112(%%rax)\n"
-		"addq $120, %%rax\n"
-		"movw %%es, (%%rax)\n"
-		"movw %%ds, 8(%%rax)\n"
-		"addq $32, %%rax\n"
-		"call __next\n" // read the current rip.
-		"__next:\n"
-		"pop %%rbx\n"
-		"addq $(out_iret -  __next), %%rbx\n"
-		"movq %%rbx, 0(%%rax)\n" // rip
-		"movw %%cs, 8(%%rax)\n"	 // cs
-		"pushfq\n"
-		"popq %%rbx\n"
-		"mov %%rbx, 16(%%rax)\n" // eflags
-		"mov %%rsp, 24(%%rax)\n" // rsp
-		"movw %%ss, 32(%%rax)\n"
-		"mov %%rcx, %%rdi\n"
-		"call do_iret\n"
-		"out_iret:\n"
-		: : "g"(tf_cur), "g"(tf) : "memory");
+	/* NOTE: [Improve] 쓰레드는 항상 schedule()을 함수 호출로 들어오므로 나가는 쪽은
+	   callee-saved 레지스터와 rsp만 저장하면 된다(switch.S).
+	   한 번도 실행되지 않은 쓰레드만 thread_create()가 만든 intr_frame을
+	   do_iret()으로 전부 복원한다. */
+	if (th->switch_rsp != 0)
+		lean_switches++;
+	else
+		full_switches++;
+	switch_threads(&curr->switch_rsp, th->switch_rsp, &th->tf);
 }
 
 /* Schedules a new process. At entry, interrupts must be off.
@@ -743,12 +1342,10 @@ do_schedule(int status)
 {
 	ASSERT(intr_get_level() == INTR_OFF);
 	ASSERT(thread_current()->status == THREAD_RUNNING);
-	while (!list_empty(&destruction_req))
-	{
-		struct thread *victim =
-			list_entry(list_pop_front(&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
-	}
+	/* NOTE: [Improve] 죽은 쓰레드의 페이지 해제는 worker에게 미룬다.
+	   workqueue가 시작되기 전에는 직접 해제한다. */
+	if (!list_empty(&destruction_req) && !work_submit(&system_wq, &reap_work))
+		reap_dead_threads(NULL);
 	thread_current()->status = status;
 	schedule();
 }
@@ -765,6 +1362,9 @@ schedule(void)
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
 
+	if (curr != next)
+		schedule_account(curr, next);
+
 	/* Start new time slice. */
 	thread_ticks = 0;
 
@@ -786,15 +1386,179 @@ schedule(void)
 		{
 			ASSERT(curr != next);
 			list_remove(&curr->all_elem); /* NOTE: [Improve] 쓰레드가 죽을 때 all_list에서 제거 */
+			if (curr->mlfqs_dirty)
+				list_remove(&curr->mlfqs_elem);
 			list_push_back(&destruction_req, &curr->elem);
 		}
 
+		/* NOTE: [Improve] FPU 상태는 옮기지 않고 CR0.TS만 맞춘다. */
+		fpu_switch(next);
+
 		/* Before switching the thread, we first save the information
 		 * of current running. */
 		thread_launch(next);
 	}
 }
 
+/**
+ * @brief CURR에서 NEXT로의 문맥 교환을 통계에 기록하는 함수
+ *
+ * CURR가 ready 상태로 내려가면서 선점 표시가 되어 있으면 비자발적 교환으로,
+ * 그 밖의 경우(block, sleep, exit, 직접 호출한 thread_yield())는 자발적 교환으로 센다.
+ * NEXT에 대해서는 ready 큐 대기 시간과 sleep 초과 시간을 기록한다.
+ */
+static void
+schedule_account(struct thread *curr, struct thread *next)
+{
+	int64_t now = timer_ticks();
+
+	if (curr != idle_thread)
+	{
+		if (curr->status == THREAD_READY && curr->stats.preempted)
+		{
+			curr->stats.involuntary_switches++;
+			involuntary_switches++;
+		}
+		else
+		{
+			curr->stats.voluntary_switches++;
+			voluntary_switches++;
+		}
+
+		/* NOTE: [Improve] slice를 다 쓴 CPU 위주 쓰레드는 slice를 늘리고,
+		   절반도 쓰기 전에 block된 I/O 위주 쓰레드는 slice를 줄인다. */
+		if (curr->status == THREAD_READY && curr->stats.preempted
+			&& thread_ticks >= thread_slice(curr))
+		{
+			curr->stats.slice_expiries++;
+			if (curr->slice_shift < SLICE_SHIFT_MAX)
+				curr->slice_shift++;
+		}
+		else if (curr->status == THREAD_BLOCKED && thread_ticks * 2 < thread_slice(curr)
+				 && curr->slice_shift > SLICE_SHIFT_MIN)
+			curr->slice_shift--;
+
+		/* NOTE: [Improve] EDF 쓰레드의 job은 스스로 block될 때 끝난 것으로 본다. */
+		if (curr->edf && curr->status == THREAD_BLOCKED && !curr->edf_throttled)
+		{
+			curr->edf_jobs++;
+			if (now > curr->edf_deadline)
+				curr->edf_misses++;
+		}
+	}
+	curr->stats.preempted = false;
+
+	if (next != idle_thread)
+	{
+		int64_t wait = now - next->stats.ready_since;
+		int bucket = 0;
+
+		while (wait > 0 && bucket < THREAD_WAIT_BUCKETS - 1)
+		{
+			wait >>= 1;
+			bucket++;
+		}
+		next->stats.ready_wait[bucket]++;
+
+		if (next->stats.sleeping)
+		{
+			if (now > next->wakeup_tick)
+				next->stats.sleep_overshoot += now - next->wakeup_tick;
+			next->stats.sleep_cnt++;
+			next->stats.sleeping = false;
+		}
+	}
+}
+
+/* Frees the pages of the threads in destruction_req.  Runs on a
+   system_wq worker, or in do_schedule() before the workqueue is
+   started. */
+static void
+reap_dead_threads(void *aux UNUSED)
+{
+	for (;;)
+	{
+		enum intr_level old_level = intr_disable();
+		struct thread *victim = NULL;
+
+		if (!list_empty(&destruction_req))
+			victim = list_entry(list_pop_front(&destruction_req), struct thread, elem);
+		intr_set_level(old_level);
+
+		if (victim == NULL)
+			break;
+		thread_page_free(victim);
+	}
+}
+
+/* Returns a page for a new thread, from the thread page cache if
+   possible.  The page is not zeroed; init_thread() initializes
+   the struct thread at its start. */
+static struct thread *
+thread_page_alloc(void)
+{
+	enum intr_level old_level = intr_disable();
+	struct thread *t = NULL;
+
+	if (!list_empty(&thread_cache))
+	{
+		t = list_entry(list_pop_front(&thread_cache), struct thread, elem);
+		thread_cache_cnt--;
+		thread_cache_hits++;
+	}
+	else
+		thread_cache_misses++;
+	intr_set_level(old_level);
+
+	if (t == NULL)
+		t = palloc_get_page(0);
+	return t;
+}
+
+/* Puts the page of dead thread T into the thread page cache, or
+   frees it if the cache is full. */
+static void
+thread_page_free(struct thread *t)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (thread_cache_cnt < thread_cache_max)
+	{
+		t->magic = 0;
+		list_push_front(&thread_cache, &t->elem);
+		thread_cache_cnt++;
+		t = NULL;
+	}
+	intr_set_level(old_level);
+
+	if (t != NULL)
+		palloc_free_page(t);
+}
+
+/* Gives every page in the thread page cache back to palloc and
+   returns the number of pages released.  Never sleeps. */
+static size_t
+thread_cache_shrink(void)
+{
+	struct list pages;
+	size_t released = 0;
+	enum intr_level old_level;
+
+	list_init(&pages);
+	old_level = intr_disable();
+	while (!list_empty(&thread_cache))
+		list_push_back(&pages, list_pop_front(&thread_cache));
+	thread_cache_cnt = 0;
+	intr_set_level(old_level);
+
+	while (!list_empty(&pages))
+	{
+		palloc_free_page(list_entry(list_pop_front(&pages), struct thread, elem));
+		released++;
+	}
+	return released;
+}
+
 /* Returns a tid to use for a new thread. */
 static tid_t
 allocate_tid(void)
@@ -802,45 +1566,125 @@ allocate_tid(void)
 	static tid_t next_tid = 1;
 	tid_t tid;
 
-	lock_acquire(&tid_lock);
+	mutex_fast_acquire(&tid_lock);
 	tid = next_tid++;
-	lock_release(&tid_lock);
+	mutex_fast_release(&tid_lock);
 
 	return tid;
 }
 
-static int64_t get_min_tick(void)
+/**
+ * @brief 쓰레드 T를 wakeup_tick에 맞는 타이밍 휠의 슬롯에 삽입하는 함수
+ *
+ * 이미 지난 wakeup_tick은 다음에 처리할 tick(wheel_tick)으로,
+ * 휠의 범위를 넘어서는 wakeup_tick은 휠의 마지막 구간으로 보정해 삽입한다.
+ * 보정된 쓰레드는 cascade될 때 실제 wakeup_tick으로 다시 삽입된다.
+ */
+static void
+sleep_wheel_insert(struct thread *t)
 {
-	if (list_empty(&sleep_list))
-		return INT64_MAX;
-	return list_entry(list_min(&sleep_list, wakeup_less, NULL), struct thread, elem)->wakeup_tick;
+	int64_t expires = t->wakeup_tick < wheel_tick ? wheel_tick : t->wakeup_tick;
+	int level, slot;
+
+	if (expires - wheel_tick >= WHEEL_SPAN)
+		expires = wheel_tick + WHEEL_SPAN - 1;
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if (expires - wheel_tick < 1LL << (WHEEL_BITS * (level + 1)))
+			break;
+
+	slot = (expires >> (WHEEL_BITS * level)) & WHEEL_MASK;
+	list_push_back(&sleep_wheel[level][slot], &t->elem);
+	sleep_wheel_map[level] |= 1ULL << slot;
 }
 
-static int set_global_tick(int64_t tick)
+/**
+ * @brief wheel_tick에서 구간이 시작되는 상위 level 슬롯들을 아래 level로 내려보내는 함수
+ *
+ * 상위 level부터 처리해야 내려온 쓰레드가 같은 tick의 하위 level 처리에 포함된다.
+ */
+static void
+sleep_wheel_cascade(void)
 {
-	if (global_tick <= tick) /* 입력받은 tick이 global_tick보다 크면 예외처리 */
-		return 0;
+	for (int level = WHEEL_LEVELS - 1; level > 0; level--)
+	{
+		int shift = WHEEL_BITS * level;
+		int slot = (wheel_tick >> shift) & WHEEL_MASK;
+		struct list moved;
+
+		if ((wheel_tick & ((1LL << shift) - 1)) != 0)
+			continue;
+		if (!(sleep_wheel_map[level] & (1ULL << slot)))
+			continue;
+
+		/* 슬롯을 비운 뒤 다시 삽입한다 */
+		list_init(&moved);
+		while (!list_empty(&sleep_wheel[level][slot]))
+			list_push_back(&moved, list_pop_front(&sleep_wheel[level][slot]));
+		sleep_wheel_map[level] &= ~(1ULL << slot);
+
+		while (!list_empty(&moved))
+			sleep_wheel_insert(list_entry(list_pop_front(&moved), struct thread, elem));
+	}
+}
 
-	/* global_tick 갱신 */
-	global_tick = tick;
-	return 1;
+/* wheel_tick에 해당하는 level 0 슬롯의 쓰레드들을 모두 깨운다. */
+static void
+sleep_wheel_expire(void)
+{
+	int slot = wheel_tick & WHEEL_MASK;
+	struct list *bucket = &sleep_wheel[0][slot];
+
+	if (!(sleep_wheel_map[0] & (1ULL << slot)))
+		return;
+
+	while (!list_empty(bucket))
+	{
+		struct thread *t = list_entry(list_pop_front(bucket), struct thread, elem);
+
+		ASSERT(t->wakeup_tick <= wheel_tick);
+		thread_unblock(t);
+	}
+	sleep_wheel_map[0] &= ~(1ULL << slot);
 }
 
 /**
- * @brief 두 쓰레드의 깨어날 시간을 비교하는 함수
+ * @brief 타이밍 휠에서 다음으로 처리할 일이 생기는 tick을 반환하는 함수
  *
- * @param a_ 첫 번째 쓰레드의 리스트 요소
- * @param b_ 두 번째 쓰레드의 리스트 요소
- * @param UNUSED 사용되지 않는 매개변수
- * @return true 첫 번째 쓰레드의 깨어날 시간이 두 번째 쓰레드의 깨어날 시간보다 이전인 경우
- * @return false 그렇지 않은 경우
+ * level 0은 가장 먼저 만료되는 슬롯의 tick을, 상위 level은 가장 먼저
+ * cascade되는 슬롯의 구간 시작 tick을 후보로 삼는다. 비트맵을 회전시켜
+ * 다음 슬롯을 찾으므로 level당 상수 시간이 든다.
+ *
+ * @return int64_t 다음 처리 tick, 휠이 비어있으면 INT64_MAX
  */
-static bool wakeup_less(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED)
+static int64_t
+sleep_wheel_next(void)
 {
-	const struct thread *a = list_entry(a_, struct thread, elem);
-	const struct thread *b = list_entry(b_, struct thread, elem);
+	int64_t next = INT64_MAX;
 
-	return a->wakeup_tick < b->wakeup_tick;
+	for (int level = 0; level < WHEEL_LEVELS; level++)
+	{
+		int shift = WHEEL_BITS * level;
+		uint64_t map = sleep_wheel_map[level];
+		int64_t block, candidate;
+		int slot;
+
+		if (map == 0)
+			continue;
+
+		/* 아직 cascade되지 않은 가장 이른 구간 */
+		block = wheel_tick >> shift;
+		if (level > 0 && (wheel_tick & ((1LL << shift) - 1)) != 0)
+			block++;
+
+		slot = block & WHEEL_MASK;
+		if (slot != 0)
+			map = (map >> slot) | (map << (WHEEL_SIZE - slot));
+		candidate = (block + __builtin_ctzll(map)) << shift;
+		if (candidate < next)
+			next = candidate;
+	}
+	return next;
 }
 
 /* NOTE: priority-insert-ordered
@@ -854,7 +1698,7 @@ static bool wakeup_less(const struct list_elem *a_, const struct list_elem *b_,
 // 	return a->priority > b->priority;
 // }
 
-bool compare_priority(struct list_elem *a, struct list_elem *b, void *aux UNUSED)
+bool compare_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
 {
 	return list_entry(a, struct thread, elem)->priority > list_entry(b, struct thread, elem)->priority;
 	//++ 우선순위 비교해주는 함수 (list_insert_ordered에 인자로 넣어줌)
@@ -867,27 +1711,15 @@ void thread_calc_priority(struct thread *t)
 	fixed_point quarter_cpu = div_fp(t->recent_cpu, int_to_fp(4));
 	int cpu_to_priority = fp_to_int_round_zero(quarter_cpu);
 	int nice_to_priority = t->nice * 2;
+	int priority = PRI_MAX - cpu_to_priority - nice_to_priority;
 
-	t->priority = PRI_MAX - cpu_to_priority - nice_to_priority;
-}
-
-/* NOTE: [1.3] recent_cpu를 계산하는 함수 구현 */
-void thread_calc_recent_cpu(struct thread *t)
-{
-	/* 계산에 필요한 정수를 고정 소수점 값으로 변경 */
-	fixed_point one = int_to_fp(1);
-	fixed_point two = int_to_fp(2);
+	/* NOTE: [Improve] ready 큐의 인덱스로 쓰이므로 범위를 벗어나지 않도록 보정 */
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	else if (priority > PRI_MAX)
+		priority = PRI_MAX;
 
-	/* decay 계산 */
-	fixed_point double_load_avg = mul_fp(two, load_avg);
-	fixed_point double_load_avg_plus_one = add_fp(double_load_avg, one);
-	fixed_point decay = div_fp(double_load_avg, double_load_avg_plus_one);
-
-	/* 감쇄된 recent_cpu 및 고정 소수점 값으로 변환한 nice */
-	fixed_point decayed_recent_cpu = mul_fp(decay, t->recent_cpu);
-	fixed_point nice_fp = int_to_fp(t->nice);
-
-	t->recent_cpu = add_fp(decayed_recent_cpu, nice_fp);
+	thread_update_priority(t, priority);
 }
 
 /* NOTE: [1.3] load_avg를 계산하는 함수 구현 */
@@ -897,8 +1729,9 @@ void calc_load_avg()
 	fixed_point weight_59 = div_fp(int_to_fp(59), int_to_fp(60));
 	fixed_point weight_1 = div_fp(int_to_fp(1), int_to_fp(60));
 
-	/* read_thread 계산: ready_list에 담긴 쓰레드의 개수 + 실행 중인 쓰레드의 개수 (idle 제외) */
-	fixed_point count_ready_threads = int_to_fp(list_size(&ready_list));
+	/* read_thread 계산: ready 큐에 담긴 쓰레드의 개수 + 실행 중인 쓰레드의 개수 (idle 제외)
+	   ready 큐의 쓰레드 개수는 ready_cnt로 유지되므로 O(1)이다. */
+	fixed_point count_ready_threads = int_to_fp(ready_cnt);
 	if (thread_current() != idle_thread)
 		count_ready_threads = add_fp(count_ready_threads, int_to_fp(1));
 
@@ -915,39 +1748,151 @@ void thread_incr_recent_cpu()
 	struct thread *curr = thread_current();
 
 	if (curr != idle_thread)
+	{
 		curr->recent_cpu = add_fp(curr->recent_cpu, int_to_fp(1));
+		mlfqs_mark_dirty(curr); /* NOTE: [Improve] 다음 재계산 대상으로 등록 */
+	}
 }
 
-/* NOTE: [1.3/Improve] `모든` 쓰레드의 우선순위를 재계산하는 함수 구현 */
-void thread_all_calc_priority()
+/**
+ * NOTE: [1.3/Improve] recent_cpu가 바뀐 쓰레드들의 우선순위만 재계산하는 함수
+ *
+ * 우선순위는 recent_cpu와 nice로만 결정되므로, 마지막 재계산 이후 recent_cpu가
+ * 바뀐 쓰레드(실행된 쓰레드와 1초마다 감쇄된 쓰레드)만 다시 계산하면 된다.
+ * 4 tick 동안 실행될 수 있는 쓰레드는 많아야 4개이므로 대부분의 tick에서 O(1)이다.
+ */
+void thread_mlfqs_recalc_priority(void)
 {
-	struct list_elem *e;
-	struct thread *t;
-
-	e = list_begin(&all_list);
-	while (e != list_end(&all_list))
+	while (!list_empty(&mlfqs_dirty_list))
 	{
-		t = list_entry(e, struct thread, all_elem);
+		struct thread *t = list_entry(list_pop_front(&mlfqs_dirty_list), struct thread, mlfqs_elem);
+
+		t->mlfqs_dirty = false;
 		thread_calc_priority(t);
-		e = list_next(e);
 	}
 }
 
-/* NOTE: [1.3/Improve] `모든` 쓰레드의 recent_cpu를 재계산하는 함수 구현 */
-void thread_all_calc_recent_cpu()
+/**
+ * NOTE: [1.3/Improve] 1초마다 recent_cpu를 감쇄하는 함수
+ *
+ * 실행 중인 쓰레드와 ready 큐의 쓰레드만 즉시 감쇄하고, block된 쓰레드는
+ * 깨어날 때(thread_unblock) decay_a, decay_b로 밀린 감쇄를 한 번에 적용한다.
+ * ready 쓰레드는 감쇄된 우선순위로 큐 위치가 바뀔 수 있으므로 여기서 방문하며,
+ * 쓰레드당 비용은 O(1)이다. 감쇄된 쓰레드의 우선순위는 다음 4 tick 경계에서
+ * 재계산된다.
+ */
+void thread_mlfqs_decay_recent_cpu(void)
 {
-	struct list_elem *e;
-	struct thread *t;
+	/* decay = (2 * load_avg) / (2 * load_avg + 1) */
+	fixed_point double_load_avg = mul_fp(int_to_fp(2), load_avg);
+	fixed_point decay = div_fp(double_load_avg, add_fp(double_load_avg, int_to_fp(1)));
+	struct thread *curr = thread_current();
+	int slot;
+
+	/* 기록된 모든 시점의 변환에 이번 감쇄 r -> decay * r + nice를 합성한다. */
+	for (slot = 0; slot < DECAY_HIST_SIZE; slot++)
+	{
+		decay_a[slot] = mul_fp(decay, decay_a[slot]);
+		decay_b[slot] = add_fp(mul_fp(decay, decay_b[slot]), int_to_fp(1));
+	}
+
+	mlfqs_seconds++;
+	slot = mlfqs_seconds % DECAY_HIST_SIZE;
+	decay_hist[slot] = decay;
+	decay_a[slot] = int_to_fp(1);
+	decay_b[slot] = 0;
+
+	if (curr != idle_thread)
+	{
+		mlfqs_catch_up(curr);
+		mlfqs_mark_dirty(curr);
+	}
 
-	e = list_begin(&all_list);
-	while (e != list_end(&all_list))
+	for (int priority = PRI_MIN; priority <= PRI_MAX; priority++)
 	{
-		t = list_entry(e, struct thread, all_elem);
-		thread_calc_recent_cpu(t);
-		e = list_next(e);
+		struct list_elem *e;
+
+		if (!(ready_bitmap & (1ULL << priority)))
+			continue;
+		for (e = list_begin(&ready_queue[priority]); e != list_end(&ready_queue[priority]); e = list_next(e))
+		{
+			struct thread *t = list_entry(e, struct thread, elem);
+
+			mlfqs_catch_up(t);
+			mlfqs_mark_dirty(t);
+		}
 	}
 }
 
+/* NOTE: [Improve] T를 다음 우선순위 재계산 대상으로 등록한다. */
+static void
+mlfqs_mark_dirty(struct thread *t)
+{
+	if (!t->mlfqs_dirty)
+	{
+		t->mlfqs_dirty = true;
+		list_push_back(&mlfqs_dirty_list, &t->mlfqs_elem);
+	}
+}
+
+/**
+ * @brief T에 밀려있는 recent_cpu 감쇄를 모두 적용하는 함수
+ *
+ * 마지막 감쇄 시점의 decay_a, decay_b로 한 번에 적용하므로 잠든 시간과
+ * 관계없이 O(1)이다. DECAY_HIST_SIZE초보다 오래된 구간은 기록에 남은 가장
+ * 오래된 decay가 계속되었다고 보고, 그 변환을 제곱을 거듭해 O(log n)에
+ * 합성한다. 계수의 곱이 고정 소수점으로 표현할 수 없을 만큼 작아지면 0으로
+ * 두고 멈춘다.
+ *
+ * @return true 감쇄가 하나 이상 적용된 경우
+ */
+static bool
+mlfqs_catch_up(struct thread *t)
+{
+	int64_t oldest = mlfqs_seconds - DECAY_HIST_SIZE + 1;
+	fixed_point nice = int_to_fp(t->nice);
+	int slot;
+
+	if (t->recent_cpu_sec >= mlfqs_seconds)
+		return false;
+
+	if (t->recent_cpu_sec < oldest)
+	{
+		/* (a, b)는 지금까지 합성한 변환, (pa, pb)는 r -> d * r + 1을 2^k번 합성한 변환 */
+		int64_t n = oldest - t->recent_cpu_sec;
+		fixed_point a = int_to_fp(1), b = 0;
+		fixed_point pa = decay_hist[oldest % DECAY_HIST_SIZE], pb = int_to_fp(1);
+
+		while (n > 0)
+		{
+			if (n & 1)
+			{
+				b = add_fp(mul_fp(pa, b), pb);
+				a = mul_fp(pa, a);
+			}
+			n >>= 1;
+			if (n == 0)
+				break;
+			pb = add_fp(mul_fp(pa, pb), pb);
+			pa = mul_fp(pa, pa);
+			if (pa == 0)
+			{
+				/* 이후의 합성은 모두 (0, pb)이다. */
+				a = 0;
+				b = pb;
+				break;
+			}
+		}
+		t->recent_cpu = add_fp(mul_fp(a, t->recent_cpu), mul_fp(nice, b));
+		t->recent_cpu_sec = oldest;
+	}
+
+	slot = t->recent_cpu_sec % DECAY_HIST_SIZE;
+	t->recent_cpu = add_fp(mul_fp(decay_a[slot], t->recent_cpu), mul_fp(nice, decay_b[slot]));
+	t->recent_cpu_sec = mlfqs_seconds;
+	return true;
+}
+
 /* NOTE: [2.3] 자식 프로세스 검색 함수 구현 */
 struct thread *get_child_process(tid_t tid)
 {
@@ -0,0 +1,165 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Maximum number of work items a worker takes at once. */
+#define WORK_BATCH 8
+
+/* Shared queue for short deferred work. */
+struct workqueue system_wq;
+
+static void worker_thread(void *wq_);
+static bool workqueue_busy(struct workqueue *wq);
+
+/* Initializes WQ and starts WORKER_CNT worker threads named NAME
+   running at PRIORITY.  Must be called after thread_start(). */
+void workqueue_init(struct workqueue *wq, const char *name, int priority, int worker_cnt)
+{
+	int i;
+
+	ASSERT(wq != NULL);
+	ASSERT(worker_cnt > 0);
+
+	wq->name = name;
+	list_init(&wq->pending);
+	list_init(&wq->idle);
+	wq->running = 0;
+	lock_init(&wq->lock);
+	cond_init(&wq->done);
+	wq->submitted_cnt = 0;
+	wq->batch_cnt = 0;
+	wq->started = true;
+
+	for (i = 0; i < worker_cnt; i++)
+		if (thread_create(name, priority, worker_thread, wq) == TID_ERROR)
+			PANIC("%s: cannot create worker thread", name);
+}
+
+/* Initializes WORK to run FUNC with AUX. */
+void work_init(struct work *work, work_func *func, void *aux)
+{
+	ASSERT(work != NULL);
+	ASSERT(func != NULL);
+
+	work->func = func;
+	work->aux = aux;
+	work->pending = false;
+}
+
+/**
+ * @brief WORK를 WQ에 제출하는 함수
+ *
+ * 인터럽트 컨텍스트와 schedule() 직전(인터럽트가 꺼진 상태)에서도 호출할 수 있도록
+ * 잠들거나 양보하지 않는다. 이미 제출되어 아직 시작되지 않은 WORK는 다시 넣지 않는다.
+ *
+ * @param wq 제출할 workqueue
+ * @param work 제출할 work
+ * @return true WORK가 실행될 예정인 경우
+ * @return false WQ의 worker가 아직 없는 경우. 호출자가 직접 처리해야 한다.
+ */
+bool work_submit(struct workqueue *wq, struct work *work)
+{
+	enum intr_level old_level;
+
+	ASSERT(wq != NULL);
+	ASSERT(work != NULL);
+
+	if (!wq->started)
+		return false;
+
+	old_level = intr_disable();
+	if (!work->pending)
+	{
+		work->pending = true;
+		list_push_back(&wq->pending, &work->elem);
+		wq->submitted_cnt++;
+
+		/* sema_up()과 달리 양보하지 않고 idle worker를 깨우기만 한다. */
+		if (!list_empty(&wq->idle))
+			thread_unblock(list_entry(list_pop_front(&wq->idle), struct thread, elem));
+	}
+	intr_set_level(old_level);
+	return true;
+}
+
+/* Waits until every work item submitted to WQ so far, and any
+   submitted meanwhile, has finished running.  Must not be
+   called from a worker of WQ. */
+void workqueue_flush(struct workqueue *wq)
+{
+	ASSERT(wq != NULL);
+	ASSERT(!intr_context());
+
+	if (!wq->started)
+		return;
+
+	lock_acquire(&wq->lock);
+	while (workqueue_busy(wq))
+		cond_wait(&wq->done, &wq->lock);
+	lock_release(&wq->lock);
+}
+
+/* Prints workqueue statistics. */
+void workqueue_print_stats(void)
+{
+	if (system_wq.started)
+		printf("Workqueue: %lld work items in %lld batches\n",
+			   system_wq.submitted_cnt, system_wq.batch_cnt);
+}
+
+/* Returns true if WQ has work that is pending or running. */
+static bool
+workqueue_busy(struct workqueue *wq)
+{
+	enum intr_level old_level = intr_disable();
+	bool busy = !list_empty(&wq->pending) || wq->running > 0;
+	intr_set_level(old_level);
+	return busy;
+}
+
+/**
+ * @brief workqueue의 worker 쓰레드
+ *
+ * 대기 중인 work를 최대 WORK_BATCH개까지 한 번에 꺼내 실행하고,
+ * 배치가 끝날 때마다 한 번만 완료를 알린다. 할 일이 없으면 idle 리스트에서 잠든다.
+ */
+static void
+worker_thread(void *wq_)
+{
+	struct workqueue *wq = wq_;
+
+	for (;;)
+	{
+		struct work *batch[WORK_BATCH];
+		enum intr_level old_level;
+		int i, n = 0;
+
+		old_level = intr_disable();
+		while (list_empty(&wq->pending))
+		{
+			list_push_back(&wq->idle, &thread_current()->elem);
+			thread_block();
+		}
+		while (n < WORK_BATCH && !list_empty(&wq->pending))
+		{
+			batch[n] = list_entry(list_pop_front(&wq->pending), struct work, elem);
+			batch[n]->pending = false;
+			n++;
+		}
+		wq->running += n;
+		wq->batch_cnt++;
+		intr_set_level(old_level);
+
+		for (i = 0; i < n; i++)
+			batch[i]->func(batch[i]->aux);
+
+		lock_acquire(&wq->lock);
+		old_level = intr_disable();
+		wq->running -= n;
+		intr_set_level(old_level);
+		cond_broadcast(&wq->done, &wq->lock);
+		lock_release(&wq->lock);
+	}
+}
@@ -45,8 +45,7 @@ void exception_init(void)
 	intr_register_int(0, 0, INTR_ON, kill, "#DE Divide Error");
 	intr_register_int(1, 0, INTR_ON, kill, "#DB Debug Exception");
 	intr_register_int(6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
-	intr_register_int(7, 0, INTR_ON, kill,
-					  "#NM Device Not Available Exception");
+	/* NOTE: [Improve] #NM은 fpu_init()이 지연 FPU 복원용으로 등록한다. */
 	intr_register_int(11, 0, INTR_ON, kill, "#NP Segment Not Present");
 	intr_register_int(12, 0, INTR_ON, kill, "#SS Stack Fault Exception");
 	intr_register_int(13, 0, INTR_ON, kill, "#GP General Protection Exception");
@@ -11,6 +11,7 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/palloc.h"
@@ -36,6 +37,8 @@ static void initd(void *f_name);
 static void __do_fork(void *);
 static void argument_stack(char **parse, int count, void **rsp);
 
+bool user_large_pages;
+
 /* General process initializer for initd and other process. */
 static void process_init(void)
 {
@@ -110,6 +113,37 @@ tid_t process_fork(const char *name, struct intr_frame *if_)
  * pml4_for_each. This is only for the project 2. */
 
 /* NOTE: [2.5] 전체 사용자 메모리 공간을 복사하는 함수에서 빠진 부분 구현 */
+static bool duplicate_large_page(uint8_t *va, uint8_t *parent_page, bool writable)
+{
+	struct thread *current = thread_current();
+	uint8_t *newpage;
+	size_t i;
+
+	newpage = palloc_get_aligned(PAL_USER, LPG_PAGES, LPGSIZE);
+	if (newpage != NULL)
+	{
+		memcpy(newpage, parent_page, LPGSIZE);
+		if (pml4_set_large_page(current->pml4, va, newpage, writable))
+			return true;
+		palloc_free_multiple(newpage, LPG_PAGES);
+		return false;
+	}
+
+	for (i = 0; i < LPG_PAGES; i++)
+	{
+		newpage = palloc_get_page(PAL_USER);
+		if (newpage == NULL)
+			return false;
+		memcpy(newpage, parent_page + i * PGSIZE, PGSIZE);
+		if (!pml4_set_page(current->pml4, va + i * PGSIZE, newpage, writable))
+		{
+			palloc_free_page(newpage);
+			return false;
+		}
+	}
+	return true;
+}
+
 static bool duplicate_pte(uint64_t *pte, void *va, void *aux)
 {
 	struct thread *current = thread_current();
@@ -127,6 +161,11 @@ static bool duplicate_pte(uint64_t *pte, void *va, void *aux)
 	if (parent_page == NULL)
 		return false;
 
+	/* NOTE: [Improve] A 2 MB page is copied as a whole when the
+	 * user pool has an aligned run for it, else as 4 kB pages. */
+	if (is_large_pte(pte))
+		return duplicate_large_page(va, parent_page, is_writable(pte));
+
 	/* 3. NOTE: Allocate new PAL_USER page for the child and set result to NEWPAGE. */
 	newpage = palloc_get_page(PAL_USER | PAL_ZERO);
 	if (newpage == NULL)
@@ -186,6 +225,10 @@ __do_fork(void *aux)
 	 * NOTE:       from the fork() until this function successfully duplicates
 	 * NOTE:       the resources of parent.*/
 
+	/* NOTE: [Improve] 부모의 FPU/SSE 상태도 물려받는다. */
+	if (!fpu_copy(current, parent))
+		goto error;
+
 	for (int i = 0; i < FDT_MAX; i++)
 	{
 		struct file *file = parent->fdt[i];
@@ -238,6 +281,7 @@ int process_exec(void *f_name) /* NOTE: 강의의 start_process() */
 
 	/* We first kill the current context */
 	process_cleanup();
+	fpu_reset(thread_current());
 
 	lock_acquire(&filesys_lock);
 	/* And then load the binary */
@@ -400,8 +444,12 @@ process_cleanup(void)
  * This function is called on every context switch. */
 void process_activate(struct thread *next)
 {
-	/* Activate thread's page tables. */
-	pml4_activate(next->pml4);
+	/* Activate thread's page tables.
+	 * NOTE: [Improve] A kernel thread has no user mappings of its
+	 * own and every page table shares the kernel half, so it keeps
+	 * running on whichever one is loaded instead of reloading CR3. */
+	if (next->pml4 != NULL)
+		pml4_activate(next->pml4);
 
 	/* Set thread's kernel stack for use in processing interrupts. */
 	tss_update(next);
@@ -676,6 +724,7 @@ validate_segment(const struct Phdr *phdr, struct file *file)
 
 /* load() helpers. */
 static bool install_page(void *upage, void *kpage, bool writable);
+static bool install_large_page(void *upage);
 
 /* Loads a segment starting at offset OFS in FILE at address
  * UPAGE.  In total, READ_BYTES + ZERO_BYTES bytes of virtual
@@ -702,6 +751,19 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 	file_seek(file, ofs);
 	while (read_bytes > 0 || zero_bytes > 0)
 	{
+		/* NOTE: [Improve] With -ulpage, each aligned 2 MB of a
+		 * writable zero-filled stretch (a large BSS) takes a single
+		 * large page and TLB entry.  Falls back to 4 kB pages when
+		 * the user pool has no aligned 2 MB run. */
+		if (user_large_pages && writable && read_bytes == 0
+			&& zero_bytes >= LPGSIZE && ((uint64_t)upage & LPGMASK) == 0
+			&& install_large_page(upage))
+		{
+			zero_bytes -= LPGSIZE;
+			upage += LPGSIZE;
+			continue;
+		}
+
 		/* Do calculate how to fill this page.
 		 * We will read PAGE_READ_BYTES bytes from FILE
 		 * and zero the final PAGE_ZERO_BYTES bytes. */
@@ -774,6 +836,25 @@ install_page(void *upage, void *kpage, bool writable)
 	 * address, then map our page there. */
 	return (pml4_get_page(t->pml4, upage) == NULL && pml4_set_page(t->pml4, upage, kpage, writable));
 }
+
+/* Maps a zeroed, writable 2 MB page at UPAGE, which must be 2 MB
+ * aligned and not yet mapped.  Returns true on success, false if
+ * there is no aligned memory for it. */
+static bool
+install_large_page(void *upage)
+{
+	struct thread *t = thread_current();
+	void *kpage = palloc_get_aligned(PAL_USER | PAL_ZERO, LPG_PAGES, LPGSIZE);
+
+	if (kpage == NULL)
+		return false;
+	if (!pml4_set_large_page(t->pml4, upage, kpage, true))
+	{
+		palloc_free_multiple(kpage, LPG_PAGES);
+		return false;
+	}
+	return true;
+}
 #else
 /* From here, codes will be used after project 3.
  * If you want to implement the function for only project 2, implement it on the
@@ -818,6 +899,8 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
+		/* NOTE: [Improve] -ulpage applies to the project 2 loader
+		 * only; anonymous pages here still come one by one. */
 		void *aux = NULL;
 		if (!vm_alloc_page_with_initializer(VM_ANON, upage,
 											writable, lazy_load_segment, aux))
@@ -50,6 +50,7 @@ int write(int fd, const void *buffer, unsigned size);
 void seek(int fd, unsigned position);
 unsigned tell(int fd);
 void close(int fd);
+int settickets(int tickets);
 
 /* file */
 bool create(const char *file, unsigned initial_size);
@@ -124,10 +125,20 @@ void syscall_handler(struct intr_frame *f)
 	case SYS_CLOSE: // 13
 		close(f->R.rdi);
 		break;
+	case SYS_SETTICKETS:
+		f->R.rax = settickets(f->R.rdi);
+		break;
 	}
 }
 
 /* ---------- SYSCALL ---------- */
+/* NOTE: [Improve] stride 스케줄러에서 현재 프로세스의 티켓 수를 바꾸는 시스템 콜
+   이전 티켓 수를 반환하고, 범위를 벗어나면 -1을 반환한다. */
+int settickets(int tickets)
+{
+	return thread_set_tickets(tickets);
+}
+
 /* NOTE: [2.2] pintos를 종료시키는 시스템 콜 */
 void halt(void)
 {